@@ -0,0 +1,167 @@
+/*
+ * bench-name-renderer.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <hildon/hildon.h>
+
+#include "osso-abook-home-name-renderer.h"
+#include "osso-abook-home-theme.h"
+
+/* Times a relayout plus expose of a contact name, done the way the applet
+ * used to, with a hildon-shadow-label GtkLabel, and with the name renderer.
+ * The name doesn't change between iterations, which is the common case.
+ */
+
+static gint iterations = 1000;
+static gchar *text = "Firstname Lastname";
+
+static GOptionEntry entries[] =
+{
+  {
+    "iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+    "Number of relayouts and exposes to time", "N"
+  },
+  {
+    "text", 't', 0, G_OPTION_ARG_STRING, &text,
+    "Name to render", "TEXT"
+  },
+  { NULL }
+};
+
+static void
+renderer_size_request_cb(GtkWidget *widget, GtkRequisition *requisition,
+                         OssoABookHomeNameRenderer *renderer)
+{
+  osso_abook_home_name_renderer_get_size(renderer, widget,
+                                         OSSO_ABOOK_HOME_THEME_LABEL_WIDTH,
+                                         &requisition->width,
+                                         &requisition->height);
+}
+
+static gboolean
+renderer_expose_event_cb(GtkWidget *widget, GdkEventExpose *event,
+                         OssoABookHomeNameRenderer *renderer)
+{
+  cairo_t *cr = gdk_cairo_create(widget->window);
+
+  gdk_cairo_region(cr, event->region);
+  cairo_clip(cr);
+  osso_abook_home_name_renderer_draw(renderer, widget, cr,
+                                     OSSO_ABOOK_HOME_THEME_LABEL_WIDTH,
+                                     0.0, 0.0);
+  cairo_destroy(cr);
+
+  return TRUE;
+}
+
+static GtkWidget *
+create_window(GtkWidget *child, int x)
+{
+  GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+
+  gtk_container_add(GTK_CONTAINER(window), child);
+  gtk_window_move(GTK_WINDOW(window), x, 0);
+  gtk_widget_show_all(window);
+  gtk_widget_show_now(window);
+
+  return window;
+}
+
+static void
+run_pending(void)
+{
+  gdk_display_sync(gdk_display_get_default());
+
+  while (gtk_events_pending())
+    gtk_main_iteration_do(FALSE);
+}
+
+/* microseconds for one relayout and expose of widget */
+static double
+time_widget(GtkWidget *widget)
+{
+  gint64 start;
+  gint i;
+
+  run_pending();
+  start = g_get_monotonic_time();
+
+  for (i = 0; i < iterations; i++)
+  {
+    gtk_widget_queue_resize(widget);
+    gtk_widget_queue_draw(widget);
+    run_pending();
+  }
+
+  return (g_get_monotonic_time() - start) / (double)iterations;
+}
+
+int
+main(int argc, char **argv)
+{
+  OssoABookHomeNameRenderer *renderer;
+  GtkWidget *label_window;
+  GtkWidget *renderer_window;
+  GtkWidget *drawing_area;
+  GtkWidget *label;
+  GError *error = NULL;
+
+  if (!gtk_init_with_args(&argc, &argv, NULL, entries, NULL, &error))
+  {
+    g_printerr("%s\n", error ? error->message : "Unable to open display");
+    g_clear_error(&error);
+
+    return 1;
+  }
+
+  if (iterations <= 0)
+  {
+    g_printerr("Iterations must be positive\n");
+
+    return 2;
+  }
+
+  label = gtk_label_new(text);
+  gtk_widget_set_name(label, "hildon-shadow-label");
+  hildon_helper_set_logical_font(label, "SmallSystemFont");
+  gtk_label_set_ellipsize(GTK_LABEL(label), PANGO_ELLIPSIZE_END);
+  gtk_widget_set_size_request(label, OSSO_ABOOK_HOME_THEME_LABEL_WIDTH, -1);
+  label_window = create_window(label, 0);
+
+  renderer = osso_abook_home_name_renderer_new();
+  osso_abook_home_name_renderer_set_text(renderer, text);
+  drawing_area = gtk_drawing_area_new();
+  g_signal_connect(drawing_area, "size-request",
+                   G_CALLBACK(renderer_size_request_cb), renderer);
+  g_signal_connect(drawing_area, "expose-event",
+                   G_CALLBACK(renderer_expose_event_cb), renderer);
+  renderer_window = create_window(drawing_area,
+                                  OSSO_ABOOK_HOME_THEME_LABEL_WIDTH);
+
+  g_print("GtkLabel: %.1f us per relayout and expose\n", time_widget(label));
+  g_print("Name renderer: %.1f us per relayout and expose\n",
+          time_widget(drawing_area));
+
+  gtk_widget_destroy(renderer_window);
+  gtk_widget_destroy(label_window);
+  osso_abook_home_name_renderer_free(renderer);
+
+  return 0;
+}
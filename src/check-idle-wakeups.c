@@ -0,0 +1,137 @@
+/*
+ * check-idle-wakeups.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <sys/wait.h>
+
+#include "osso-abook-home-trace.h"
+
+/* Replays a short synthetic trace with osso-abook-home-replay --fast, lets
+ * it sit idle and fails if anything woke its main loop up meanwhile.
+ */
+
+#define N_APPLETS 10
+#define IDLE_SECONDS "5"
+
+static void
+write_event(FILE *file, OssoABookHomeTraceType type,
+            OssoABookHomeTraceContact *contacts, guint n_contacts)
+{
+  OssoABookHomeTraceEvent event;
+
+  event.type = type;
+  event.delay = 0;
+  event.n_contacts = n_contacts;
+  event.contacts = contacts;
+  osso_abook_home_trace_write(file, &event);
+}
+
+static gboolean
+write_trace(int fd)
+{
+  OssoABookHomeTraceContact contacts[N_APPLETS];
+  FILE *file = fdopen(fd, "wb");
+  gboolean written;
+  guint i;
+
+  if (!file)
+    return FALSE;
+
+  osso_abook_home_trace_write_header(file);
+
+  for (i = 0; i < N_APPLETS; i++)
+  {
+    contacts[i].id = i + 1;
+    contacts[i].presence_type = TP_CONNECTION_PRESENCE_TYPE_AVAILABLE;
+    contacts[i].name_length = 10 + i;
+    contacts[i].avatar_serial = 1;
+    write_event(file, OSSO_ABOOK_HOME_TRACE_APPLET, &contacts[i], 1);
+  }
+
+  write_event(file, OSSO_ABOOK_HOME_TRACE_CONTACTS_ADDED, contacts,
+              N_APPLETS);
+
+  /* a bit of everything the applets react to */
+  for (i = 0; i < N_APPLETS; i++)
+  {
+    contacts[i].presence_type = TP_CONNECTION_PRESENCE_TYPE_AWAY;
+    write_event(file, OSSO_ABOOK_HOME_TRACE_PRESENCE_TYPE, &contacts[i], 1);
+    contacts[i].avatar_serial++;
+    write_event(file, OSSO_ABOOK_HOME_TRACE_AVATAR_IMAGE, &contacts[i], 1);
+    contacts[i].name_length++;
+    write_event(file, OSSO_ABOOK_HOME_TRACE_RESET, &contacts[i], 1);
+  }
+
+  /* no contacts-removed, the applet would drop itself from the settings */
+  written = !ferror(file);
+
+  return !fclose(file) && written;
+}
+
+int
+main(int argc, char **argv)
+{
+  gchar *command[] =
+  {
+    "./osso-abook-home-replay", "--fast", "--idle", IDLE_SECONDS, NULL, NULL
+  };
+  GError *error = NULL;
+  gchar *path = NULL;
+  int status = 0;
+  int rv = 1;
+  int fd;
+
+  /* skipped, nothing to show applets on */
+  if (!g_getenv("DISPLAY"))
+    return 77;
+
+  fd = g_file_open_tmp("osso-abook-home-trace-XXXXXX", &path, &error);
+
+  if (fd < 0 || !write_trace(fd))
+  {
+    g_printerr("Unable to write trace: %s\n",
+               error ? error->message : g_strerror(errno));
+    g_clear_error(&error);
+    g_free(path);
+
+    return 1;
+  }
+
+  command[4] = path;
+
+  if (!g_spawn_sync(NULL, command, NULL, G_SPAWN_CHILD_INHERITS_STDIN, NULL,
+                    NULL, NULL, NULL, &status, &error))
+  {
+    g_printerr("Unable to run %s: %s\n", command[0], error->message);
+    g_clear_error(&error);
+  }
+  else if (WIFEXITED(status) && !WEXITSTATUS(status))
+    rv = 0;
+  else
+    g_printerr("%s failed with status %d\n", command[0], status);
+
+  g_unlink(path);
+  g_free(path);
+
+  return rv;
+}
@@ -0,0 +1,89 @@
+/*
+ * check-memory-budget.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-player.h"
+
+/* Fails if any of N applets, shown with the longest names and an avatar
+ * each, goes over OSSO_ABOOK_HOME_MEMORY_APPLET_BUDGET.
+ */
+
+#define N_APPLETS 20
+
+int
+main(int argc, char **argv)
+{
+  OssoABookHomeTraceContact contacts[N_APPLETS];
+  OssoABookHomeTraceEvent event;
+  gchar *report;
+  guint over_budget;
+  int rv;
+  guint i;
+
+  /* skipped, nothing to show applets on */
+  if (!g_getenv("DISPLAY"))
+    return 77;
+
+  rv = osso_abook_home_player_init("check-memory-budget", &argc, &argv,
+                                   NULL, NULL);
+
+  if (rv)
+    return rv;
+
+  osso_abook_home_player_start();
+  event.delay = 0;
+
+  for (i = 0; i < N_APPLETS; i++)
+  {
+    contacts[i].id = i + 1;
+    contacts[i].presence_type = TP_CONNECTION_PRESENCE_TYPE_AVAILABLE;
+    contacts[i].name_length = 255;
+    contacts[i].avatar_serial = 1;
+
+    event.type = OSSO_ABOOK_HOME_TRACE_APPLET;
+    event.n_contacts = 1;
+    event.contacts = &contacts[i];
+    osso_abook_home_player_play(&event);
+  }
+
+  event.type = OSSO_ABOOK_HOME_TRACE_CONTACTS_ADDED;
+  event.n_contacts = N_APPLETS;
+  event.contacts = contacts;
+  osso_abook_home_player_play(&event);
+
+  report = osso_abook_home_memory_report();
+  g_print("%s", report);
+  g_free(report);
+
+  over_budget = osso_abook_home_memory_get_over_budget();
+
+  if (over_budget)
+  {
+    g_printerr("%u of %u applets are over the budget of %d bytes\n",
+               over_budget, N_APPLETS, OSSO_ABOOK_HOME_MEMORY_APPLET_BUDGET);
+    rv = 1;
+  }
+
+  osso_abook_home_player_stop();
+  osso_abook_home_player_deinit();
+
+  return rv;
+}
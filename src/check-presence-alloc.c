@@ -0,0 +1,212 @@
+/*
+ * check-presence-alloc.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "osso-abook-home-player.h"
+
+/* Fails if a presence change, or an avatar notify for the same image,
+ * allocates in the applet once it is warmed up, redraw included.
+ * The allocator is wrapped by defining it here, the executable comes first
+ * in symbol lookup, so glib, gtk and libosso-abook get these too.
+ */
+
+#define ROUNDS 3
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static pthread_t main_thread;
+static volatile gboolean counting = FALSE;
+static volatile guint allocations = 0;
+
+/* other threads of the process have nothing to do with the update */
+static void
+count()
+{
+  if (counting && pthread_equal(pthread_self(), main_thread))
+    allocations++;
+}
+
+void *
+malloc(size_t size)
+{
+  count();
+
+  return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+  count();
+
+  return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+  count();
+
+  return __libc_realloc(ptr, size);
+}
+
+void *
+memalign(size_t alignment, size_t size)
+{
+  count();
+
+  return __libc_memalign(alignment, size);
+}
+
+int
+posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+  count();
+  *memptr = __libc_memalign(alignment, size);
+
+  return *memptr ? 0 : ENOMEM;
+}
+
+void
+free(void *ptr)
+{
+  __libc_free(ptr);
+}
+
+static const guint8 presence_types[] =
+{
+  TP_CONNECTION_PRESENCE_TYPE_AVAILABLE,
+  TP_CONNECTION_PRESENCE_TYPE_AWAY,
+  TP_CONNECTION_PRESENCE_TYPE_BUSY
+};
+
+static void
+play(OssoABookHomeTraceType type, OssoABookHomeTraceContact *contact)
+{
+  OssoABookHomeTraceEvent event;
+
+  event.type = type;
+  event.delay = 0;
+  event.n_contacts = 1;
+  event.contacts = contact;
+  osso_abook_home_player_play(&event);
+}
+
+/* counts what the notify and the redraw it leads to allocate. A full
+ * redraw is queued beforehand, so what the applet invalidates merges into it
+ * without gdk scheduling a new update. */
+static guint
+count_notify(GtkWidget *applet, OssoABookContact *contact,
+             const char *property)
+{
+  gtk_widget_queue_draw(applet);
+
+  allocations = 0;
+  counting = TRUE;
+  g_object_notify(G_OBJECT(contact), property);
+  osso_abook_home_player_flush();
+  counting = FALSE;
+
+  return allocations;
+}
+
+/* the first round warms up caches and slice magazines, the others must not
+ * allocate */
+static guint
+change_presence(OssoABookHomeTraceContact *trace_contact)
+{
+  GtkWidget *applet =
+    g_ptr_array_index(osso_abook_home_player_get_applets(), 0);
+  guint round;
+  guint i;
+
+  for (round = 0; round < ROUNDS; round++)
+  {
+    for (i = 0; i < G_N_ELEMENTS(presence_types); i++)
+    {
+      OssoABookContact *contact;
+      guint presence_allocations;
+      guint avatar_allocations;
+
+      trace_contact->presence_type = presence_types[i];
+      contact = osso_abook_home_player_set_state(trace_contact);
+      presence_allocations = count_notify(applet, contact, "presence-type");
+
+      /* avatar_serial stays the same, so does the image */
+      avatar_allocations = count_notify(applet, contact, "avatar-image");
+
+      if (round && presence_allocations)
+      {
+        g_printerr("Presence change to %u made %u allocations\n",
+                   presence_types[i], presence_allocations);
+        return presence_allocations;
+      }
+
+      if (round && avatar_allocations)
+      {
+        g_printerr("Unchanged avatar notify made %u allocations\n",
+                   avatar_allocations);
+        return avatar_allocations;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+  OssoABookHomeTraceContact contact = { 1, 0, 8, 1 };
+  int rv;
+
+  main_thread = pthread_self();
+
+  /* skipped, nothing to show applets on */
+  if (!g_getenv("DISPLAY"))
+    return 77;
+
+  rv = osso_abook_home_player_init("check-presence-alloc", &argc, &argv,
+                                   NULL, NULL);
+
+  if (rv)
+    return rv;
+
+  osso_abook_home_player_start();
+  play(OSSO_ABOOK_HOME_TRACE_APPLET, &contact);
+  contact.presence_type = TP_CONNECTION_PRESENCE_TYPE_OFFLINE;
+  play(OSSO_ABOOK_HOME_TRACE_CONTACTS_ADDED, &contact);
+
+  if (change_presence(&contact))
+    rv = 1;
+
+  osso_abook_home_player_stop();
+  osso_abook_home_player_deinit();
+
+  return rv;
+}
@@ -0,0 +1,338 @@
+/*
+ * check-shortcuts.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <gconf/gconf-client.h>
+#include <libhildondesktop/hd-shortcuts.h>
+#include <libosso-abook/osso-abook-settings.h>
+
+#include <string.h>
+
+#include "osso-abook-home-aggregator.h"
+#include "osso-abook-home-applet.h"
+#include "osso-abook-home-dbus.h"
+#include "osso-abook-home-player.h"
+
+/* Calls AddShortcuts and RemoveShortcuts over a private session bus and
+ * checks the replies against what ends up in GConf. HDShortcuts creates and
+ * destroys the applets, which resolve against the backend-less replay
+ * aggregator, and each batch has to get to a single filter update without
+ * falling back to its timeout. Run by check-shortcuts.sh under
+ * dbus-run-session, with HOME pointing at an empty directory.
+ */
+
+#define CALL_TIMEOUT 10000
+
+/* well below the batch timeout, a batch that needs it has failed */
+#define THAW_TIMEOUT 5000
+
+static DBusConnection *service = NULL;
+static DBusConnection *client = NULL;
+static guint filter_changes = 0;
+
+static void
+filter_changed_cb(OssoABookContactFilter *filter)
+{
+  filter_changes++;
+}
+
+static gboolean
+thaw_timeout_cb(gpointer user_data)
+{
+  *(gboolean *)user_data = TRUE;
+
+  return FALSE;
+}
+
+/* the applets come and go from HDShortcuts' GConf notify, on the default
+ * main context */
+static gboolean
+wait_thawed()
+{
+  gboolean timed_out = FALSE;
+  guint timeout_id = g_timeout_add(THAW_TIMEOUT, thaw_timeout_cb, &timed_out);
+
+  while (osso_abook_home_aggregator_subscriptions_frozen() && !timed_out)
+    g_main_context_iteration(NULL, TRUE);
+
+  if (!timed_out)
+    g_source_remove(timeout_id);
+
+  return !timed_out;
+}
+
+/* the method reply or error, NULL if the call failed on the client side */
+static DBusMessage *
+call(const char *method, const char * const *uids)
+{
+  DBusPendingCall *pending = NULL;
+  DBusMessage *message;
+  DBusMessage *reply;
+
+  message = dbus_message_new_method_call(
+      dbus_bus_get_unique_name(service), OSSO_ABOOK_HOME_APPLET_DBUS_PATH,
+      OSSO_ABOOK_HOME_APPLET_DBUS_INTERFACE, method);
+
+  if (uids)
+  {
+    int n_uids = g_strv_length((gchar **)uids);
+
+    dbus_message_append_args(message, DBUS_TYPE_ARRAY, DBUS_TYPE_STRING,
+                             &uids, n_uids, DBUS_TYPE_INVALID);
+  }
+
+  if (!dbus_connection_send_with_reply(client, message, &pending,
+                                       CALL_TIMEOUT) || !pending)
+  {
+    dbus_message_unref(message);
+
+    return NULL;
+  }
+
+  dbus_message_unref(message);
+
+  /* both ends live in this process, so both get pumped */
+  while (!dbus_pending_call_get_completed(pending))
+  {
+    dbus_connection_read_write_dispatch(client, 10);
+    dbus_connection_read_write_dispatch(service, 10);
+  }
+
+  reply = dbus_pending_call_steal_reply(pending);
+  dbus_pending_call_unref(pending);
+
+  return reply;
+}
+
+static gboolean
+check_call(const char *method, const char * const *uids,
+           dbus_uint32_t expected, guint expected_filter_changes)
+{
+  DBusMessage *reply;
+  dbus_uint32_t changed;
+  DBusError error;
+
+  filter_changes = 0;
+  reply = call(method, uids);
+
+  if (!reply)
+  {
+    g_printerr("%s: no reply\n", method);
+
+    return FALSE;
+  }
+
+  dbus_error_init(&error);
+
+  if (dbus_set_error_from_message(&error, reply) ||
+      !dbus_message_get_args(reply, &error, DBUS_TYPE_UINT32, &changed,
+                             DBUS_TYPE_INVALID))
+  {
+    g_printerr("%s: %s\n", method, error.message);
+    dbus_error_free(&error);
+    dbus_message_unref(reply);
+
+    return FALSE;
+  }
+
+  dbus_message_unref(reply);
+
+  if (changed != expected)
+  {
+    g_printerr("%s: %u applets changed, expected %u\n", method, changed,
+               expected);
+
+    return FALSE;
+  }
+
+  if (!wait_thawed())
+  {
+    g_printerr("%s: subscriptions still frozen after %d ms\n", method,
+               THAW_TIMEOUT);
+
+    return FALSE;
+  }
+
+  if (filter_changes != expected_filter_changes)
+  {
+    g_printerr("%s: %u filter changes, expected %u\n", method,
+               filter_changes, expected_filter_changes);
+
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+check_error(const char *method)
+{
+  DBusMessage *reply = call(method, NULL);
+  gboolean rv;
+
+  if (!reply)
+  {
+    g_printerr("%s: no reply\n", method);
+
+    return FALSE;
+  }
+
+  rv = dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_ERROR;
+  dbus_message_unref(reply);
+
+  if (!rv)
+    g_printerr("%s: no error for a call without UIDs\n", method);
+
+  return rv;
+}
+
+/* expected are contact UIDs, the list holds applet ids */
+static gboolean
+check_list(GConfClient *gconf, const char * const *expected)
+{
+  GError *error = NULL;
+  GSList *home_applets;
+  gboolean rv = TRUE;
+  GSList *l;
+
+  home_applets = gconf_client_get_list(gconf, OSSO_ABOOK_HOME_APPLETS_GCONF_KEY,
+                                       GCONF_VALUE_STRING, &error);
+
+  if (error)
+  {
+    g_printerr("%s\n", error->message);
+    g_error_free(error);
+
+    return FALSE;
+  }
+
+  for (l = home_applets; l; l = l->next, expected++)
+  {
+    gchar *id;
+
+    if (!*expected)
+    {
+      g_printerr("Unexpected applet %s\n", (const char *)l->data);
+      rv = FALSE;
+      break;
+    }
+
+    id = g_strconcat(OSSO_ABOOK_HOME_APPLET_PREFIX, *expected, NULL);
+
+    if (strcmp(l->data, id))
+    {
+      g_printerr("Applet %s, expected %s\n", (const char *)l->data, id);
+      rv = FALSE;
+    }
+
+    g_free(id);
+
+    if (!rv)
+      break;
+  }
+
+  if (rv && *expected)
+  {
+    g_printerr("Missing applet for %s\n", *expected);
+    rv = FALSE;
+  }
+
+  g_slist_free_full(home_applets, g_free);
+
+  return rv;
+}
+
+int
+main(int argc, char **argv)
+{
+  static const char *added[] = { "a", "b", "c", NULL };
+  static const char *removed[] = { "a", "x", NULL };
+  static const char *remaining[] = { "b", "c", NULL };
+  static const char *none[] = { NULL };
+  HDShortcuts *shortcuts;
+  GConfClient *gconf;
+  DBusError error;
+  int rv;
+
+  /* skipped, nothing to create applets on */
+  if (!g_getenv("DISPLAY"))
+    return 77;
+
+  rv = osso_abook_home_player_init("check-shortcuts", &argc, &argv, NULL,
+                                   NULL);
+
+  if (rv)
+    return rv;
+
+  rv = 1;
+  dbus_error_init(&error);
+  service = dbus_bus_get_private(DBUS_BUS_SESSION, &error);
+
+  if (service)
+    client = dbus_bus_get_private(DBUS_BUS_SESSION, &error);
+
+  if (!client)
+  {
+    g_printerr("%s\n", error.message);
+    dbus_error_free(&error);
+    osso_abook_home_player_deinit();
+
+    return 1;
+  }
+
+  dbus_connection_add_filter(service, osso_abook_home_dbus_filter, NULL,
+                             NULL);
+  g_signal_connect(osso_abook_home_aggregator_get_subscriptions(),
+                   "contact-filter-changed", G_CALLBACK(filter_changed_cb),
+                   NULL);
+  osso_abook_home_aggregator_start_replay();
+
+  gconf = gconf_client_get_default();
+  gconf_client_unset(gconf, OSSO_ABOOK_HOME_APPLETS_GCONF_KEY, NULL);
+  gconf_client_add_dir(gconf, "/apps/osso-addressbook",
+                       GCONF_CLIENT_PRELOAD_NONE, NULL);
+  shortcuts = hd_shortcuts_new(OSSO_ABOOK_HOME_APPLETS_GCONF_KEY,
+                               OSSO_ABOOK_TYPE_HOME_APPLET);
+
+  if (check_list(gconf, none) &&
+      check_error("AddShortcuts") &&
+      check_call("AddShortcuts", added, 3, 1) &&
+      check_list(gconf, added) &&
+      check_call("AddShortcuts", added, 0, 0) &&
+      check_list(gconf, added) &&
+      check_call("RemoveShortcuts", removed, 1, 1) &&
+      check_list(gconf, remaining) &&
+      check_call("RemoveShortcuts", removed, 0, 0) &&
+      check_list(gconf, remaining))
+  {
+    rv = 0;
+  }
+
+  g_object_unref(shortcuts);
+  gconf_client_unset(gconf, OSSO_ABOOK_HOME_APPLETS_GCONF_KEY, NULL);
+  g_object_unref(gconf);
+  dbus_connection_close(client);
+  dbus_connection_unref(client);
+  dbus_connection_close(service);
+  dbus_connection_unref(service);
+  osso_abook_home_player_deinit();
+
+  return rv;
+}
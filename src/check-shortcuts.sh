@@ -0,0 +1,11 @@
+#!/bin/sh
+# Runs check-shortcuts on its own session bus, with a scratch HOME so the
+# GConf it writes to is not the user's.
+
+command -v dbus-run-session > /dev/null || exit 77
+
+HOME=$(mktemp -d) || exit 1
+export HOME
+trap 'rm -rf "$HOME"' EXIT
+
+dbus-run-session -- ./check-shortcuts
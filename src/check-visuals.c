@@ -0,0 +1,191 @@
+/*
+ * check-visuals.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-stats.h"
+#include "osso-abook-home-theme.h"
+
+/* Fails unless the theme surfaces are converted once per visual, for an RGBA
+ * and an RGB window, and come out in the window's own surface type with the
+ * content they are painted with.
+ */
+
+/* frame, active frame and avatar mask */
+#define CONVERSIONS_PER_VISUAL 3
+
+static GtkWidget *
+create_window(GdkColormap *colormap)
+{
+  GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+
+  gtk_widget_set_colormap(window, colormap);
+  gtk_widget_realize(window);
+
+  return window;
+}
+
+static gboolean
+check_surface(const char *what, GdkWindow *window, cairo_surface_t *surface,
+              cairo_content_t content)
+{
+  cairo_t *cr;
+  cairo_surface_type_t type;
+
+  if (!surface)
+  {
+    g_printerr("%s: no surface\n", what);
+
+    return FALSE;
+  }
+
+  cr = gdk_cairo_create(window);
+  type = cairo_surface_get_type(cairo_get_target(cr));
+  cairo_destroy(cr);
+
+  if (cairo_surface_get_type(surface) != type)
+  {
+    g_printerr("%s: surface type %d, window is %d\n", what,
+               cairo_surface_get_type(surface), type);
+
+    return FALSE;
+  }
+
+  if (cairo_surface_get_content(surface) != content)
+  {
+    g_printerr("%s: content 0x%x, expected 0x%x\n", what,
+               cairo_surface_get_content(surface), content);
+
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* gets everything twice, the second time must come from the cache */
+static gboolean
+check_window(const char *name, GtkWidget *widget, cairo_surface_t **frame)
+{
+  GdkWindow *window = widget->window;
+  guint conversions =
+    osso_abook_home_stats_get_count(OSSO_ABOOK_HOME_COUNTER_THEME_CONVERSION);
+  cairo_surface_t *frame_active;
+  cairo_surface_t *avatar_mask;
+  gchar *what;
+  gboolean rv;
+  int i;
+
+  for (i = 0; i < 2; i++)
+  {
+    *frame = osso_abook_home_theme_get_frame(window, FALSE);
+    frame_active = osso_abook_home_theme_get_frame(window, TRUE);
+    avatar_mask = osso_abook_home_theme_get_avatar_mask(window);
+  }
+
+  conversions =
+    osso_abook_home_stats_get_count(OSSO_ABOOK_HOME_COUNTER_THEME_CONVERSION) -
+    conversions;
+
+  if (conversions != CONVERSIONS_PER_VISUAL)
+  {
+    g_printerr("%s: %u conversions, expected %d\n", name, conversions,
+               CONVERSIONS_PER_VISUAL);
+
+    return FALSE;
+  }
+
+  what = g_strconcat(name, " frame", NULL);
+  rv = check_surface(what, window, *frame, CAIRO_CONTENT_COLOR_ALPHA);
+  g_free(what);
+
+  if (rv)
+  {
+    what = g_strconcat(name, " active frame", NULL);
+    rv = check_surface(what, window, frame_active, CAIRO_CONTENT_COLOR_ALPHA);
+    g_free(what);
+  }
+
+  if (rv)
+  {
+    what = g_strconcat(name, " avatar mask", NULL);
+    rv = check_surface(what, window, avatar_mask, CAIRO_CONTENT_ALPHA);
+    g_free(what);
+  }
+
+  return rv;
+}
+
+int
+main(int argc, char **argv)
+{
+  cairo_surface_t *rgba_frame = NULL;
+  cairo_surface_t *rgb_frame = NULL;
+  GdkColormap *rgba_colormap;
+  GtkWidget *rgba_window;
+  GtkWidget *rgb_window;
+  GdkScreen *screen;
+  gchar *filename;
+  gchar *report;
+  int rv = 0;
+
+  /* skipped, nothing to create windows on */
+  if (!gtk_init_check(&argc, &argv))
+    return 77;
+
+  screen = gdk_screen_get_default();
+  rgba_colormap = gdk_screen_get_rgba_colormap(screen);
+
+  /* skipped, the server has no visual with alpha */
+  if (!rgba_colormap)
+    return 77;
+
+  rgb_window = create_window(gdk_screen_get_rgb_colormap(screen));
+  rgba_window = create_window(rgba_colormap);
+
+  /* skipped, no theme with the applet images */
+  filename = gtk_rc_find_pixmap_in_path(gtk_widget_get_settings(rgb_window),
+                                        NULL, "ContactsAppletFrame.png");
+
+  if (!filename)
+    return 77;
+
+  g_free(filename);
+  osso_abook_home_theme_update(rgb_window);
+
+  if (!check_window("RGBA", rgba_window, &rgba_frame) ||
+      !check_window("RGB", rgb_window, &rgb_frame))
+  {
+    rv = 1;
+  }
+  else if (rgba_frame == rgb_frame)
+  {
+    g_printerr("RGBA and RGB windows share a frame surface\n");
+    rv = 1;
+  }
+
+  report = osso_abook_home_memory_report();
+  g_print("%s", report);
+  g_free(report);
+
+  gtk_widget_destroy(rgba_window);
+  gtk_widget_destroy(rgb_window);
+
+  return rv;
+}
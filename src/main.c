@@ -19,11 +19,19 @@
 
 #include "config.h"
 
+#include <glib-unix.h>
 #include <libosso-abook/osso-abook-init.h>
 #include <libhildondesktop/hd-shortcuts.h>
 #include <gconf/gconf-client.h>
 
+#include <signal.h>
+
 #include "osso-abook-home-applet.h"
+#include "osso-abook-home-dbus.h"
+#include "osso-abook-home-group-applet.h"
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-stats.h"
+#include "osso-abook-home-wakeups.h"
 
 static DBusHandlerResult
 dsme_dbus_filter(DBusConnection *connection, DBusMessage *message,
@@ -35,6 +43,28 @@ dsme_dbus_filter(DBusConnection *connection, DBusMessage *message,
   return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
 }
 
+static gboolean
+dump_stats_cb(gpointer user_data)
+{
+  gchar *report = osso_abook_home_memory_report();
+
+  g_message("%s", report);
+  g_free(report);
+
+  report = osso_abook_home_wakeups_report();
+  g_message("%s", report);
+  g_free(report);
+
+  if (osso_abook_home_wakeups_get_periodic())
+    g_warning("Periodic wakeups detected");
+
+  report = osso_abook_home_stats_report();
+  g_message("%s", report);
+  g_free(report);
+
+  return TRUE;
+}
+
 int
 main(int argc, char **argv, const char **envp)
 {
@@ -56,6 +86,7 @@ main(int argc, char **argv, const char **envp)
   {
     DBusConnection *dbus = dbus_bus_get(DBUS_BUS_SYSTEM, NULL);
     HDShortcuts *shortcuts;
+    HDShortcuts *group_shortcuts;
 
     if (dbus)
     {
@@ -64,14 +95,29 @@ main(int argc, char **argv, const char **envp)
       dbus_connection_add_filter(dbus, dsme_dbus_filter, NULL, NULL);
     }
 
+    dbus = osso_get_dbus_connection(osso);
+
+    if (dbus)
+    {
+      dbus_bus_request_name(dbus, OSSO_ABOOK_HOME_APPLET_DBUS_SERVICE,
+                            DBUS_NAME_FLAG_DO_NOT_QUEUE, NULL);
+      dbus_connection_add_filter(dbus, osso_abook_home_dbus_filter, NULL,
+                                 NULL);
+    }
+
+    g_unix_signal_add(SIGUSR1, dump_stats_cb, NULL);
+
     gconf = gconf_client_get_default();
     gconf_client_add_dir(gconf,
                          "/apps/osso-addressbook",
                          GCONF_CLIENT_PRELOAD_NONE,
                          NULL);
-    shortcuts = hd_shortcuts_new("/apps/osso-addressbook/home-applets",
+    shortcuts = hd_shortcuts_new(OSSO_ABOOK_HOME_APPLETS_GCONF_KEY,
                                  OSSO_ABOOK_TYPE_HOME_APPLET);
+    group_shortcuts = hd_shortcuts_new(OSSO_ABOOK_HOME_GROUP_APPLETS_GCONF_KEY,
+                                       OSSO_ABOOK_TYPE_HOME_GROUP_APPLET);
     gtk_main();
+    g_object_unref(group_shortcuts);
     g_object_unref(shortcuts);
     g_object_unref(gconf);
   }
@@ -0,0 +1,559 @@
+/*
+ * osso-abook-home-aggregator.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <libosso-abook/osso-abook-debug.h>
+#include <libosso-abook/osso-abook-init.h>
+#include <libosso-abook/osso-abook-waitable.h>
+
+#include "osso-abook-home-aggregator.h"
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-trace.h"
+#include "osso-abook-home-wakeups.h"
+
+/* first retry happens after RECOVERY_DELAY_MIN seconds, every following one
+ * doubles that up to RECOVERY_DELAY_MAX. An aggregator that stayed up for
+ * RECOVERY_STABLE_TIME resets the backoff.
+ */
+#define RECOVERY_DELAY_MIN 2
+#define RECOVERY_DELAY_MAX 60
+#define RECOVERY_STABLE_TIME (60 * G_USEC_PER_SEC)
+
+struct _OssoABookHomeAggregatorClient
+{
+  OssoABookHomeAggregatorFunc attach;
+  OssoABookHomeAggregatorFunc detach;
+  gpointer user_data;
+  gboolean attached;
+};
+
+typedef struct _OssoABookHomeAggregatorClient OssoABookHomeAggregatorClient;
+
+static OssoABookAggregator *aggregator = NULL;
+static OssoABookWaitableClosure *ready_closure = NULL;
+static gint64 ready_time = 0;
+static GList *clients = NULL;
+
+static guint recovery_id = 0;
+static guint recovery_attempt = 0;
+
+/* UID -> number of tiles showing it, the filter only changes when a UID
+ * comes or goes, and not at all while frozen. Frozen changes go to pending,
+ * UID -> whether the filter had it when it first changed. */
+static OssoABookContactSubscriptions *contact_subscriptions = NULL;
+static GHashTable *subscribed = NULL;
+static GHashTable *pending = NULL;
+static guint freeze_count = 0;
+
+/* master contacts for the subscribed UIDs, kept in sync from the roster
+ * signals so a lookup of a shown contact neither allocates nor walks the
+ * aggregator. Keys are our own copies. */
+static GHashTable *contacts = NULL;
+
+OssoABookContactSubscriptions *
+osso_abook_home_aggregator_get_subscriptions()
+{
+  if (!contact_subscriptions)
+    contact_subscriptions = osso_abook_contact_subscriptions_new();
+
+  return contact_subscriptions;
+}
+
+static gboolean
+is_subscribed(const char *uid)
+{
+  return uid && subscribed && g_hash_table_lookup(subscribed, uid);
+}
+
+static void
+set_pending(const char *uid, gboolean applied)
+{
+  if (!pending)
+    pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+  if (!g_hash_table_lookup_extended(pending, uid, NULL, NULL))
+    g_hash_table_insert(pending, g_strdup(uid), GINT_TO_POINTER(applied));
+}
+
+void
+osso_abook_home_aggregator_subscribe(const char *uid)
+{
+  guint count;
+
+  if (!subscribed)
+    subscribed = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+  count = GPOINTER_TO_UINT(g_hash_table_lookup(subscribed, uid));
+  g_hash_table_insert(subscribed, g_strdup(uid), GUINT_TO_POINTER(count + 1));
+
+  if (count)
+    return;
+
+  if (freeze_count)
+    set_pending(uid, FALSE);
+  else
+  {
+    osso_abook_contact_subscriptions_add(
+      osso_abook_home_aggregator_get_subscriptions(), uid);
+  }
+}
+
+void
+osso_abook_home_aggregator_unsubscribe(const char *uid)
+{
+  guint count;
+
+  if (!subscribed)
+    return;
+
+  count = GPOINTER_TO_UINT(g_hash_table_lookup(subscribed, uid));
+
+  if (count > 1)
+  {
+    g_hash_table_insert(subscribed, g_strdup(uid),
+                        GUINT_TO_POINTER(count - 1));
+    return;
+  }
+
+  if (!count)
+    return;
+
+  if (freeze_count)
+    set_pending(uid, TRUE);
+  else
+  {
+    osso_abook_contact_subscriptions_remove(
+      osso_abook_home_aggregator_get_subscriptions(), uid);
+  }
+
+  g_hash_table_remove(subscribed, uid);
+
+  if (contacts)
+    g_hash_table_remove(contacts, uid);
+}
+
+void
+osso_abook_home_aggregator_freeze_subscriptions()
+{
+  freeze_count++;
+}
+
+/* every change but the last one is made with the filter's change handlers
+ * blocked, so the aggregator refilters once for the whole list */
+static void
+apply_changes(GPtrArray *uids, gboolean add)
+{
+  OssoABookContactSubscriptions *subscriptions =
+    osso_abook_home_aggregator_get_subscriptions();
+  guint signal_id = g_signal_lookup("contact-filter-changed",
+                                    OSSO_ABOOK_TYPE_CONTACT_FILTER);
+  guint i;
+
+  if (!uids->len)
+    return;
+
+  g_signal_handlers_block_matched(subscriptions, G_SIGNAL_MATCH_ID,
+                                  signal_id, 0, NULL, NULL, NULL);
+
+  for (i = 0; i < uids->len; i++)
+  {
+    if (i == uids->len - 1)
+    {
+      g_signal_handlers_unblock_matched(subscriptions, G_SIGNAL_MATCH_ID,
+                                        signal_id, 0, NULL, NULL, NULL);
+    }
+
+    if (add)
+      osso_abook_contact_subscriptions_add(subscriptions, uids->pdata[i]);
+    else
+      osso_abook_contact_subscriptions_remove(subscriptions, uids->pdata[i]);
+  }
+}
+
+/* UIDs that came and went again while frozen cancel out. Removals and
+ * additions narrow and widen the filter, so each kind gets its own update,
+ * a batch of shortcut changes is only ever one kind. */
+void
+osso_abook_home_aggregator_thaw_subscriptions()
+{
+  GPtrArray *removed;
+  GPtrArray *added;
+  GHashTableIter iter;
+  gpointer uid;
+  gpointer applied;
+
+  g_return_if_fail(freeze_count > 0);
+
+  if (--freeze_count || !pending)
+    return;
+
+  removed = g_ptr_array_new();
+  added = g_ptr_array_new();
+  g_hash_table_iter_init(&iter, pending);
+
+  while (g_hash_table_iter_next(&iter, &uid, &applied))
+  {
+    if (is_subscribed(uid) && !GPOINTER_TO_INT(applied))
+      g_ptr_array_add(added, uid);
+    else if (!is_subscribed(uid) && GPOINTER_TO_INT(applied))
+      g_ptr_array_add(removed, uid);
+  }
+
+  apply_changes(removed, FALSE);
+  apply_changes(added, TRUE);
+  g_ptr_array_free(removed, TRUE);
+  g_ptr_array_free(added, TRUE);
+  g_hash_table_destroy(pending);
+  pending = NULL;
+}
+
+gboolean
+osso_abook_home_aggregator_subscriptions_frozen()
+{
+  return freeze_count > 0;
+}
+
+static void
+attach_client(OssoABookHomeAggregatorClient *client)
+{
+  if (!client->attached)
+  {
+    client->attached = TRUE;
+    client->attach(aggregator, client->user_data);
+  }
+}
+
+static void
+aggregator_ready_cb(OssoABookWaitable *waitable, const GError *error,
+                    gpointer user_data)
+{
+  GList *l = clients;
+
+  ready_closure = NULL;
+  ready_time = g_get_monotonic_time();
+
+  if (error)
+    g_warning("%s: %s", __FUNCTION__, error->message);
+
+  while (l)
+  {
+    GList *next = l->next;
+
+    attach_client(l->data);
+    l = next;
+  }
+}
+
+static gsize
+vcard_size(EVCard *vcard)
+{
+  GList *attr;
+  gsize size = 0;
+
+  for (attr = e_vcard_get_attributes(vcard); attr; attr = attr->next)
+  {
+    GList *value = e_vcard_attribute_get_values(attr->data);
+
+    size += 8 * sizeof(gpointer) +
+      strlen(e_vcard_attribute_get_name(attr->data));
+
+    for (; value; value = value->next)
+      size += sizeof(GList) + strlen(value->data) + 1;
+  }
+
+  return size;
+}
+
+static void
+roster_memory_usage_cb(gsize *sizes, gpointer user_data)
+{
+  GHashTableIter iter;
+  gpointer contact;
+
+  if (!contacts)
+    return;
+
+  g_hash_table_iter_init(&iter, contacts);
+
+  while (g_hash_table_iter_next(&iter, NULL, &contact))
+  {
+    GTypeQuery query;
+
+    g_type_query(G_OBJECT_TYPE(contact), &query);
+    sizes[OSSO_ABOOK_HOME_MEMORY_ROSTER] +=
+      query.instance_size + vcard_size(E_VCARD(contact));
+  }
+}
+
+static void
+contacts_added_cb(OssoABookRoster *roster, OssoABookContact **added,
+                  gpointer user_data)
+{
+  for (; *added; added++)
+  {
+    const char *uid = e_contact_get_const(E_CONTACT(*added), E_CONTACT_UID);
+
+    if (is_subscribed(uid))
+      g_hash_table_insert(contacts, g_strdup(uid), g_object_ref(*added));
+  }
+}
+
+/* entries cached from a fallback lookup are keyed by the UID the tile asked
+ * for, which can be a roster contact's, so match on the master too */
+static gboolean
+contact_removed(gpointer key, gpointer value, gpointer user_data)
+{
+  const char *uid = user_data;
+
+  return !strcmp(key, uid) ||
+         !g_strcmp0(e_contact_get_const(E_CONTACT(value), E_CONTACT_UID), uid);
+}
+
+static void
+contacts_removed_cb(OssoABookRoster *roster, const char **uids,
+                    gpointer user_data)
+{
+  for (; *uids; uids++)
+    g_hash_table_foreach_remove(contacts, contact_removed, (gpointer)*uids);
+}
+
+/* connected before any client, so the table is up to date by the time
+ * clients get the same signals */
+static void
+watch_aggregator()
+{
+  if (!contacts)
+  {
+    contacts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                     g_object_unref);
+  }
+
+  g_signal_connect(aggregator, "contacts-added",
+                   G_CALLBACK(contacts_added_cb), NULL);
+  g_signal_connect(aggregator, "contacts-removed",
+                   G_CALLBACK(contacts_removed_cb), NULL);
+}
+
+static gboolean
+backend_died_cb(EBook *book, gpointer user_data);
+
+static void
+create_aggregator()
+{
+  static gboolean initialized = FALSE;
+
+  if (!initialized)
+  {
+    osso_abook_set_backend_died_func(backend_died_cb, NULL);
+    osso_abook_home_memory_add_shared("aggregator", roster_memory_usage_cb,
+                                      NULL);
+    initialized = TRUE;
+  }
+
+  aggregator = OSSO_ABOOK_AGGREGATOR(osso_abook_aggregator_new(NULL, NULL));
+  osso_abook_aggregator_add_filter(
+    aggregator,
+    OSSO_ABOOK_CONTACT_FILTER(osso_abook_home_aggregator_get_subscriptions()));
+  watch_aggregator();
+  osso_abook_home_trace_watch_roster(OSSO_ABOOK_ROSTER(aggregator));
+  osso_abook_roster_start(OSSO_ABOOK_ROSTER(aggregator));
+  ready_closure = osso_abook_waitable_call_when_ready(
+      OSSO_ABOOK_WAITABLE(aggregator), aggregator_ready_cb, NULL, NULL);
+}
+
+static gboolean
+recovery_cb(gpointer user_data)
+{
+  recovery_id = 0;
+
+  OSSO_ABOOK_NOTE(GENERIC, "Recreating aggregator, attempt %d",
+                  recovery_attempt);
+
+  if (clients && !aggregator)
+    create_aggregator();
+
+  return FALSE;
+}
+
+static void
+schedule_recovery()
+{
+  guint delay;
+
+  if (ready_time &&
+      (g_get_monotonic_time() - ready_time > RECOVERY_STABLE_TIME))
+  {
+    recovery_attempt = 0;
+  }
+
+  ready_time = 0;
+
+  delay = RECOVERY_DELAY_MIN << MIN(recovery_attempt, 6);
+  delay = MIN(delay, RECOVERY_DELAY_MAX);
+
+  /* add up to 25% of jitter, so we don't retry in lockstep with the other
+   * abook users that lost the same backend */
+  delay += g_random_int_range(0, delay / 4 + 1);
+  recovery_attempt++;
+
+  if (recovery_id)
+    g_source_remove(recovery_id);
+
+  recovery_id = osso_abook_home_wakeups_timeout_add_seconds(
+      OSSO_ABOOK_HOME_WAKEUP_RECOVERY, delay, recovery_cb, NULL);
+}
+
+static gboolean
+backend_died_cb(EBook *book, gpointer user_data)
+{
+  ESource *source = e_book_get_source(book);
+  GList *l;
+
+  g_warning("Backend for %s died. Starting over.", e_source_get_uid(source));
+
+  if (!aggregator)
+    return TRUE;
+
+  if (ready_closure)
+  {
+    osso_abook_waitable_cancel(OSSO_ABOOK_WAITABLE(aggregator),
+                               ready_closure);
+    ready_closure = NULL;
+  }
+
+  /* clients keep their last resolved contacts around until the new
+   * aggregator is ready, they just have to stop listening to this one */
+  for (l = clients; l; l = l->next)
+  {
+    OssoABookHomeAggregatorClient *client = l->data;
+
+    if (client->attached)
+    {
+      client->attached = FALSE;
+      client->detach(aggregator, client->user_data);
+    }
+  }
+
+  g_hash_table_remove_all(contacts);
+  g_object_unref(aggregator);
+  aggregator = NULL;
+
+  osso_abook_roster_manager_stop(osso_abook_roster_manager_get_default());
+  schedule_recovery();
+
+  return TRUE;
+}
+
+void
+osso_abook_home_aggregator_add_client(OssoABookHomeAggregatorFunc attach,
+                                      OssoABookHomeAggregatorFunc detach,
+                                      gpointer user_data)
+{
+  OssoABookHomeAggregatorClient *client;
+
+  g_return_if_fail(attach != NULL);
+  g_return_if_fail(detach != NULL);
+
+  client = g_slice_new0(OssoABookHomeAggregatorClient);
+  client->attach = attach;
+  client->detach = detach;
+  client->user_data = user_data;
+  clients = g_list_prepend(clients, client);
+
+  if (!aggregator)
+  {
+    if (!recovery_id)
+      create_aggregator();
+  }
+  else if (ready_time)
+    attach_client(client);
+}
+
+void
+osso_abook_home_aggregator_remove_client(gpointer user_data)
+{
+  GList *l;
+
+  for (l = clients; l; l = l->next)
+  {
+    OssoABookHomeAggregatorClient *client = l->data;
+
+    if (client->user_data == user_data)
+    {
+      clients = g_list_delete_link(clients, l);
+      g_slice_free(OssoABookHomeAggregatorClient, client);
+      break;
+    }
+  }
+}
+
+OssoABookContact *
+osso_abook_home_aggregator_lookup(const char *uid)
+{
+  OssoABookContact *contact;
+  GList *l;
+
+  if (!contacts || !aggregator)
+    return NULL;
+
+  contact = g_hash_table_lookup(contacts, uid);
+
+  if (contact)
+    return contact;
+
+  /* UIDs of roster contacts, or of masters added before the subscription,
+   * only the aggregator can resolve */
+  l = osso_abook_aggregator_lookup(aggregator, uid);
+
+  if (!l)
+    return NULL;
+
+  contact = l->data;
+  g_list_free(l);
+
+  if (is_subscribed(uid))
+    g_hash_table_insert(contacts, g_strdup(uid), g_object_ref(contact));
+
+  return contact;
+}
+
+OssoABookAggregator *
+osso_abook_home_aggregator_start_replay()
+{
+  GList *l = clients;
+
+  g_return_val_if_fail(aggregator == NULL, NULL);
+
+  aggregator = g_object_new(OSSO_ABOOK_TYPE_AGGREGATOR, NULL);
+  watch_aggregator();
+  ready_time = g_get_monotonic_time();
+
+  while (l)
+  {
+    GList *next = l->next;
+
+    attach_client(l->data);
+    l = next;
+  }
+
+  return aggregator;
+}
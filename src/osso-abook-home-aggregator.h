@@ -0,0 +1,77 @@
+/*
+ * osso-abook-home-aggregator.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_AGGREGATOR_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_AGGREGATOR_H_INCLUDED__
+
+#include <libosso-abook/osso-abook-aggregator.h>
+#include <libosso-abook/osso-abook-contact-subscriptions.h>
+
+G_BEGIN_DECLS
+
+/* Called with the process-wide aggregator once it is ready (attach) and
+ * right before it is dropped because its backend died (detach).
+ */
+typedef void (*OssoABookHomeAggregatorFunc)(OssoABookAggregator *aggregator,
+                                            gpointer user_data);
+
+OssoABookContactSubscriptions *
+osso_abook_home_aggregator_get_subscriptions(void);
+
+/* reference counted, a UID stays subscribed while any tile shows it */
+void
+osso_abook_home_aggregator_subscribe(const char *uid);
+
+void
+osso_abook_home_aggregator_unsubscribe(const char *uid);
+
+/* batches subscription changes into a single update of the filter on the
+ * last thaw, nests */
+void
+osso_abook_home_aggregator_freeze_subscriptions(void);
+
+void
+osso_abook_home_aggregator_thaw_subscriptions(void);
+
+gboolean
+osso_abook_home_aggregator_subscriptions_frozen(void);
+
+void
+osso_abook_home_aggregator_add_client(OssoABookHomeAggregatorFunc attach,
+                                      OssoABookHomeAggregatorFunc detach,
+                                      gpointer user_data);
+
+void
+osso_abook_home_aggregator_remove_client(gpointer user_data);
+
+/* first master contact for uid, or NULL. Answered from a table for the
+ * subscribed UIDs, anything else goes to the aggregator. */
+OssoABookContact *
+osso_abook_home_aggregator_lookup(const char *uid);
+
+/* Replay seam, used by the trace player instead of a real aggregator.
+ * Clients get attached to a backend-less aggregator right away, the caller
+ * emits the roster signals on it.
+ */
+OssoABookAggregator *
+osso_abook_home_aggregator_start_replay(void);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_AGGREGATOR_H_INCLUDED__ */
@@ -19,31 +19,45 @@
 
 #include "config.h"
 
+#include <gconf/gconf-client.h>
+#include <glib/gstdio.h>
 #include <hildon/hildon.h>
-#include <libosso-abook/osso-abook-aggregator.h>
-#include <libosso-abook/osso-abook-contact-subscriptions.h>
 #include <libosso-abook/osso-abook-debug.h>
 #include <libosso-abook/osso-abook-icon-sizes.h>
 #include <libosso-abook/osso-abook-init.h>
-#include <libosso-abook/osso-abook-presence-icon.h>
 #include <libosso-abook/osso-abook-touch-contact-starter.h>
-#include <libosso-abook/osso-abook-waitable.h>
 
+#include "osso-abook-home-aggregator.h"
 #include "osso-abook-home-applet.h"
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-name-renderer.h"
+#include "osso-abook-home-presence-atlas.h"
+#include "osso-abook-home-startup.h"
+#include "osso-abook-home-stats.h"
+#include "osso-abook-home-theme.h"
+#include "osso-abook-home-thumbnail-store.h"
+#include "osso-abook-home-trace.h"
+#include "osso-abook-home-wakeups.h"
 
 struct _OssoABookHomeAppletPrivate
 {
   OssoABookAggregator *aggregator;
   OssoABookContact *contact;
   gchar *uid;
-  GdkPixbuf *avatar_image;
+  cairo_surface_t *avatar_image;
+  cairo_surface_t *avatar_native;
+  gconstpointer avatar_token;
   GtkWidget *fixed;
-  GtkWidget *image;
+  gboolean pressed;
+  gint64 press_time;
   GtkWidget *presence_icon;
-  GtkWidget *label;
+  GtkWidget *name_area;
+  OssoABookHomeNameRenderer *name;
   gulong contacts_removed_id;
   gulong contacts_added_id;
-  guint respawn_id;
+  GList pending_link;
+  gboolean pending;
+  gint presence_index;
   int flags;
 };
 
@@ -60,85 +74,163 @@ G_DEFINE_TYPE_WITH_PRIVATE(
    osso_abook_home_applet_get_instance_private((OssoABookHomeApplet *) \
                                                (applet)))
 
-static void
-aggregator_weak_notify(void *data, GObject *where_the_object_was);
-
-static OssoABookAggregator *aggregator = NULL;
-static guint respawn_count = 0;
-static guint respawn_timeout_id;
 static guint idle_update_id = 0;
-static GList *applets = NULL;
+/* applets that lost their contact, linked through their pending_link */
+static GQueue applets = G_QUEUE_INIT;
 
 static GtkWidget *dialog = NULL;
 
-static GdkPixbuf *frame_active_pixbuf = NULL;
-static GdkPixbuf *frame_pixbuf = NULL;
-static cairo_surface_t *avatar_mask = NULL;
-static GtkStyle *style = NULL;
-
-static gboolean
-abook_backend_died_cd(EBook *book, gpointer user_data)
+/* key of the PHOTO the avatar gets scaled from, valid until the next call,
+ * NULL if there is none and the avatar comes from a roster contact or an
+ * icon. Neither the photo nor the file it points to is read, an URI is
+ * versioned by the file's mtime and size and inline data by the contact's
+ * revision. */
+static const char *
+get_avatar_key(OssoABookContact *contact)
 {
-  ESource *source = e_book_get_source(book);
+  static GString *source = NULL;
+  EVCardAttribute *attr = e_vcard_get_attribute(E_VCARD(contact), EVC_PHOTO);
+  GList *value_param;
+
+  if (!attr)
+    return NULL;
+
+  /* reused, keys get built on every avatar change */
+  if (!source)
+    source = g_string_sized_new(256);
+
+  g_string_truncate(source, 0);
+  value_param = e_vcard_attribute_get_param(attr, EVC_VALUE);
 
-  if (++respawn_count > 3)
+  if (value_param && !g_ascii_strcasecmp(value_param->data, "uri"))
   {
-    g_critical("Backend for %s died and respawn limit exceeded. Aborting.",
-               e_source_get_uid(source));
-    return FALSE;
+    GList *values = e_vcard_attribute_get_values(attr);
+    const char *uri = values ? values->data : NULL;
+    const char *filename;
+    gchar *decoded = NULL;
+    GStatBuf st;
+
+    if (!uri)
+      return NULL;
+
+    /* plain local paths, what the address book writes, need no decoding */
+    if (g_str_has_prefix(uri, "file:///") && !strchr(uri, '%'))
+      filename = uri + strlen("file://");
+    else
+      filename = decoded = g_filename_from_uri(uri, NULL, NULL);
+
+    if (filename && !g_stat(filename, &st))
+    {
+      g_string_append_printf(source, "%s\n%ld\n%" G_GINT64_FORMAT, uri,
+                             (long)st.st_mtime, (gint64)st.st_size);
+    }
+
+    g_free(decoded);
   }
+  else
+  {
+    const char *uid = e_contact_get_const(E_CONTACT(contact), E_CONTACT_UID);
+    const char *rev = e_contact_get_const(E_CONTACT(contact), E_CONTACT_REV);
 
-  g_warning("Backend for %s died. Starting over.", e_source_get_uid(source));
+    /* without a revision there is nothing cheap that tells photos apart */
+    if (uid && rev)
+      g_string_append_printf(source, "%s\n%s", uid, rev);
+  }
 
-  if (aggregator)
-    g_object_unref(aggregator);
+  if (!source->len)
+    return NULL;
 
-  aggregator = NULL;
+  return osso_abook_home_thumbnail_store_get_key(source->str);
+}
 
-  return TRUE;
+/* an avatar changing to another one of the same size is painted over the
+ * old pixels instead of allocating new ones */
+static gboolean
+can_reuse_surface(cairo_surface_t *surface, int width, int height)
+{
+  return (cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE) &&
+         (cairo_surface_get_reference_count(surface) == 1) &&
+         (cairo_image_surface_get_format(surface) == CAIRO_FORMAT_ARGB32) &&
+         (cairo_image_surface_get_width(surface) == width) &&
+         (cairo_image_surface_get_height(surface) == height) &&
+         !osso_abook_home_thumbnail_store_is_mapped(surface);
 }
 
-static OssoABookContactSubscriptions *
-get_contact_subscriptions()
+static cairo_surface_t *
+create_avatar_surface(GdkPixbuf *pixbuf, cairo_surface_t *previous)
 {
-  static OssoABookContactSubscriptions *contact_subscriptions = NULL;
+  int width = gdk_pixbuf_get_width(pixbuf);
+  int height = gdk_pixbuf_get_height(pixbuf);
+  cairo_surface_t *surface = NULL;
+  cairo_t *cr;
+
+  if (previous)
+  {
+    if (can_reuse_surface(previous, width, height))
+      surface = previous;
+    else
+      cairo_surface_destroy(previous);
+  }
 
-  if (!contact_subscriptions)
-    contact_subscriptions = osso_abook_contact_subscriptions_new();
+  if (!surface)
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
 
-  return contact_subscriptions;
+  cr = cairo_create(surface);
+
+  gdk_cairo_set_source_pixbuf(cr, pixbuf, 0.0, 0.0);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+
+  return surface;
 }
 
-static void
-contact_notify_avatar_image_cb(OssoABookHomeApplet *applet)
+cairo_surface_t *
+osso_abook_home_applet_load_avatar(OssoABookContact *contact,
+                                   cairo_surface_t *previous)
 {
-  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  GdkPixbuf *avatar_image = NULL;
+  cairo_surface_t *surface;
+  const char *key = NULL;
 
-  if (priv->avatar_image)
+  if (contact)
   {
-    g_object_unref(priv->avatar_image);
-    priv->avatar_image = NULL;
-  }
+    key = get_avatar_key(contact);
 
-  if (priv->contact)
-  {
-    priv->avatar_image = osso_abook_avatar_get_image_scaled(
-        OSSO_ABOOK_AVATAR(priv->contact),
+    if (key)
+    {
+      surface = osso_abook_home_thumbnail_store_lookup(
+          key, OSSO_ABOOK_PIXEL_SIZE_AVATAR_MEDIUM);
+
+      if (surface)
+      {
+        if (previous)
+          cairo_surface_destroy(previous);
+
+        return surface;
+      }
+    }
+
+    avatar_image = osso_abook_avatar_get_image_scaled(
+        OSSO_ABOOK_AVATAR(contact),
         OSSO_ABOOK_PIXEL_SIZE_AVATAR_MEDIUM,
         OSSO_ABOOK_PIXEL_SIZE_AVATAR_MEDIUM,
         TRUE);
   }
 
-  if (!priv->avatar_image)
+  if (!avatar_image)
   {
-    if (priv->contact && OSSO_ABOOK_IS_AVATAR(priv->contact))
+    /* fallback icons are not worth a thumbnail */
+    key = NULL;
+
+    if (contact && OSSO_ABOOK_IS_AVATAR(contact))
     {
       const char *fallback_icon = osso_abook_avatar_get_fallback_icon_name(
-          OSSO_ABOOK_AVATAR(priv->contact));
+          OSSO_ABOOK_AVATAR(contact));
 
       if (fallback_icon)
       {
-        priv->avatar_image = gtk_icon_theme_load_icon(
+        avatar_image = gtk_icon_theme_load_icon(
             gtk_icon_theme_get_default(), fallback_icon,
             OSSO_ABOOK_PIXEL_SIZE_AVATAR_MEDIUM, GTK_ICON_LOOKUP_USE_BUILTIN,
             NULL);
@@ -146,33 +238,168 @@ contact_notify_avatar_image_cb(OssoABookHomeApplet *applet)
     }
   }
 
-  if (!priv->avatar_image)
+  if (!avatar_image)
   {
-    priv->avatar_image = gtk_icon_theme_load_icon(
+    avatar_image = gtk_icon_theme_load_icon(
         gtk_icon_theme_get_default(), "general_default_avatar",
         OSSO_ABOOK_PIXEL_SIZE_AVATAR_MEDIUM, GTK_ICON_LOOKUP_USE_BUILTIN,
         NULL);
   }
 
+  if (!avatar_image)
+  {
+    if (previous)
+      cairo_surface_destroy(previous);
+
+    return NULL;
+  }
+
+  surface = create_avatar_surface(avatar_image, previous);
+  g_object_unref(avatar_image);
+
+  if (key)
+  {
+    osso_abook_home_thumbnail_store_save(
+      key, OSSO_ABOOK_PIXEL_SIZE_AVATAR_MEDIUM, surface);
+  }
+
+  return surface;
+}
+
+static void
+drop_avatar_native(OssoABookHomeAppletPrivate *priv)
+{
+  if (priv->avatar_native)
+  {
+    cairo_surface_destroy(priv->avatar_native);
+    priv->avatar_native = NULL;
+  }
+}
+
+/* the masked avatar in the format of our window, so an expose is a single
+ * server side composite instead of an upload through the mask */
+static cairo_surface_t *
+get_avatar_native(OssoABookHomeApplet *applet)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  GdkWindow *window = GTK_WIDGET(applet)->window;
+  cairo_surface_t *avatar_mask;
+  cairo_t *cr;
+
+  if (priv->avatar_native || !priv->avatar_image)
+    return priv->avatar_native;
+
+  avatar_mask = osso_abook_home_theme_get_avatar_mask(window);
+
+  if (!avatar_mask)
+    return NULL;
+
+  priv->avatar_native = osso_abook_home_theme_create_similar(
+      window, priv->avatar_image, CAIRO_CONTENT_COLOR_ALPHA);
+  cr = cairo_create(priv->avatar_native);
+  cairo_set_operator(cr, CAIRO_OPERATOR_DEST_IN);
+  cairo_set_source_surface(cr, avatar_mask, 0.0, 0.0);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+
+  return priv->avatar_native;
+}
+
+static void
+load_avatar(OssoABookHomeApplet *applet)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+
+  drop_avatar_native(priv);
+  priv->avatar_image =
+    osso_abook_home_applet_load_avatar(priv->contact, priv->avatar_image);
+  priv->avatar_token = osso_abook_avatar_get_image_token(
+      OSSO_ABOOK_AVATAR(priv->contact));
   gtk_widget_queue_draw(GTK_WIDGET(applet));
 }
 
+/* notifies with the image still the same come often and must not cost
+ * anything, the token tells them apart without touching the image */
 static void
-contact_notify_presence_type_cb(OssoABookHomeApplet *applet)
+contact_notify_avatar_image_cb(OssoABookHomeApplet *applet)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+
+  if (osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(priv->contact)) !=
+      priv->avatar_token)
+  {
+    load_avatar(applet);
+  }
+}
+
+static int
+get_name_max_width(OssoABookHomeAppletPrivate *priv)
+{
+  int max_width = OSSO_ABOOK_HOME_THEME_LABEL_WIDTH;
+
+  if (GTK_WIDGET_VISIBLE(priv->presence_icon))
+    max_width -= OSSO_ABOOK_HOME_PRESENCE_ATLAS_ICON_SIZE + 8;
+
+  return max_width;
+}
+
+/* the name area only reserves space in the hbox, the text itself is painted
+ * from the renderer's cached bitmap, so a resize is needed only when the
+ * bitmap size really changed */
+static void
+update_name_size(OssoABookHomeApplet *applet)
 {
   OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  int old_width;
+  int old_height;
+  int width;
+  int height;
+
+  osso_abook_home_name_renderer_get_size(priv->name, GTK_WIDGET(applet),
+                                         get_name_max_width(priv),
+                                         &width, &height);
+  gtk_widget_get_size_request(priv->name_area, &old_width, &old_height);
+
+  if ((width != old_width) || (height != old_height))
+    gtk_widget_set_size_request(priv->name_area, width, height);
+}
 
-  if (osso_abook_presence_get_icon_name(OSSO_ABOOK_PRESENCE(priv->contact)))
+static gboolean
+update_presence(OssoABookHomeApplet *applet)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  const char *icon_name =
+    osso_abook_presence_get_icon_name(OSSO_ABOOK_PRESENCE(priv->contact));
+  gint presence_index = osso_abook_home_presence_atlas_lookup(icon_name);
+
+  if (presence_index == priv->presence_index)
+    return FALSE;
+
+  priv->presence_index = presence_index;
+
+  if (priv->presence_index >= 0)
+  {
     gtk_widget_show(priv->presence_icon);
+    gtk_widget_queue_draw(priv->presence_icon);
+  }
   else
     gtk_widget_hide(priv->presence_icon);
+
+  update_name_size(applet);
+
+  return TRUE;
 }
 
 static void
-update_nickname(OssoABookHomeApplet *applet)
+contact_notify_presence_type_cb(OssoABookHomeApplet *applet)
 {
-  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
-  EContact *ec = E_CONTACT(priv->contact);
+  update_presence(applet);
+}
+
+const char *
+osso_abook_home_applet_get_contact_name(OssoABookContact *contact)
+{
+  EContact *ec = E_CONTACT(contact);
   const gchar *nickname;
 
   nickname = e_contact_get_const(ec, E_CONTACT_NICKNAME);
@@ -187,20 +414,69 @@ update_nickname(OssoABookHomeApplet *applet)
     nickname = e_contact_get_const(ec, E_CONTACT_ORG);
 
   if (!nickname || !*nickname)
-    nickname = osso_abook_contact_get_display_name(priv->contact);
+    nickname = osso_abook_contact_get_display_name(contact);
+
+  return nickname;
+}
+
+static gboolean
+update_nickname(OssoABookHomeApplet *applet)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  const gchar *nickname =
+    osso_abook_home_applet_get_contact_name(priv->contact);
+
+  if (!osso_abook_home_name_renderer_set_text(priv->name, nickname))
+    return FALSE;
 
   OSSO_ABOOK_NOTE(GENERIC, "Update nickname to %s", nickname);
-  gtk_label_set_text(GTK_LABEL(priv->label), nickname);
+  update_name_size(applet);
+  gtk_widget_queue_draw(priv->name_area);
+
+  return TRUE;
+}
+
+/* reset is emitted on any vCard change, most of them touch fields we never
+ * show, so only do widget work for the name, avatar or presence */
+static void
+contact_reset_cb(OssoABookHomeApplet *applet)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  gboolean changed = FALSE;
+
+  osso_abook_home_stats_count(OSSO_ABOOK_HOME_COUNTER_RESET);
+
+  if (update_nickname(applet))
+    changed = TRUE;
+
+  if (osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(priv->contact)) !=
+      priv->avatar_token)
+  {
+    load_avatar(applet);
+    changed = TRUE;
+  }
+
+  if (update_presence(applet))
+    changed = TRUE;
+
+  if (!changed)
+    osso_abook_home_stats_count(OSSO_ABOOK_HOME_COUNTER_RESET_SKIPPED);
 }
 
 static void
 remove_applet(OssoABookHomeApplet *applet)
 {
-  applets = g_list_remove(applets, applet);
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+
+  if (priv->pending)
+  {
+    g_queue_unlink(&applets, &priv->pending_link);
+    priv->pending = FALSE;
+  }
 
   if (idle_update_id)
   {
-    if (!applets)
+    if (g_queue_is_empty(&applets))
     {
       g_source_remove(idle_update_id);
       idle_update_id = 0;
@@ -208,23 +484,56 @@ remove_applet(OssoABookHomeApplet *applet)
   }
 }
 
+/* only an identical PHOTO is trusted, avatars coming from roster contacts
+ * can't be compared without loading them */
+static gboolean
+contact_photo_equal(OssoABookContact *a, OssoABookContact *b)
+{
+  EContactPhoto *photo_a = e_contact_get(E_CONTACT(a), E_CONTACT_PHOTO);
+  EContactPhoto *photo_b = e_contact_get(E_CONTACT(b), E_CONTACT_PHOTO);
+  gboolean equal = FALSE;
+
+  if (photo_a && photo_b && (photo_a->type == photo_b->type))
+  {
+    if (photo_a->type == E_CONTACT_PHOTO_TYPE_INLINED)
+    {
+      equal = photo_a->data.inlined.length == photo_b->data.inlined.length &&
+        !memcmp(photo_a->data.inlined.data, photo_b->data.inlined.data,
+                photo_a->data.inlined.length);
+    }
+    else
+      equal = !g_strcmp0(photo_a->data.uri, photo_b->data.uri);
+  }
+
+  if (photo_a)
+    e_contact_photo_free(photo_a);
+
+  if (photo_b)
+    e_contact_photo_free(photo_b);
+
+  return equal;
+}
+
 static void
 update_contact(OssoABookHomeApplet *applet, OssoABookContact *contact)
 {
   OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  OssoABookContact *old_contact = priv->contact;
 
-  if (priv->contact)
+  if (contact && (contact == old_contact))
+    return;
+
+  if (old_contact)
   {
     g_signal_handlers_disconnect_matched(
-      priv->contact, G_SIGNAL_MATCH_DATA | G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+      old_contact, G_SIGNAL_MATCH_DATA | G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
       contact_notify_avatar_image_cb, applet);
     g_signal_handlers_disconnect_matched(
-      priv->contact, G_SIGNAL_MATCH_DATA | G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+      old_contact, G_SIGNAL_MATCH_DATA | G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
       contact_notify_presence_type_cb, applet);
     g_signal_handlers_disconnect_matched(
-      priv->contact, G_SIGNAL_MATCH_DATA | G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
-      update_nickname, applet);
-    g_object_unref(priv->contact);
+      old_contact, G_SIGNAL_MATCH_DATA | G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+      contact_reset_cb, applet);
     priv->contact = NULL;
   }
 
@@ -232,22 +541,33 @@ update_contact(OssoABookHomeApplet *applet, OssoABookContact *contact)
   {
     remove_applet(applet);
     priv->contact = g_object_ref(contact);
-    contact_notify_avatar_image_cb(applet);
+
+    /* after the aggregator got recreated, we get a new object for the same
+     * contact, keep what is already displayed unless it really changed */
+    if (!old_contact || !contact_photo_equal(old_contact, contact))
+      load_avatar(applet);
+    else
+    {
+      priv->avatar_token =
+        osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(contact));
+    }
+
     g_signal_connect_swapped(
       contact, "notify::avatar-image",
       G_CALLBACK(contact_notify_avatar_image_cb), applet);
-    osso_abook_presence_icon_set_presence(
-      OSSO_ABOOK_PRESENCE_ICON(priv->presence_icon),
-      OSSO_ABOOK_PRESENCE(contact));
-    contact_notify_presence_type_cb(applet);
+    update_presence(applet);
     g_signal_connect_swapped(
       contact, "notify::presence-type",
       G_CALLBACK(contact_notify_presence_type_cb), applet);
     update_nickname(applet);
     g_signal_connect_swapped(contact, "reset",
-                             G_CALLBACK(update_nickname), applet);
+                             G_CALLBACK(contact_reset_cb), applet);
+    osso_abook_home_trace_watch_contact(contact);
     gtk_widget_show(GTK_WIDGET(applet));
   }
+
+  if (old_contact)
+    g_object_unref(old_contact);
 }
 
 static void
@@ -257,15 +577,7 @@ check_contacts(OssoABookHomeApplet *applet)
   OssoABookContact *contact = NULL;
 
   if (priv->aggregator)
-  {
-    GList *l = osso_abook_aggregator_lookup(priv->aggregator, priv->uid);
-
-    if (l)
-    {
-      contact = l->data;
-      g_list_free(l);
-    }
-  }
+    contact = osso_abook_home_aggregator_lookup(priv->uid);
 
   update_contact(applet, contact);
 }
@@ -273,19 +585,23 @@ check_contacts(OssoABookHomeApplet *applet)
 static gboolean
 idle_update_applets(gpointer user_data)
 {
-  GSList *home_applets = osso_abook_settings_get_home_applets();
+  GSList *home_applets = NULL;
+  gboolean fetched = FALSE;
   gboolean removed = FALSE;
-  GList *applet = applets;
+  GList *applet;
 
-  while (applet)
+  while ((applet = g_queue_peek_head_link(&applets)))
   {
     OssoABookHomeAppletPrivate *priv = PRIVATE(applet->data);
     GSList *l;
 
     if (priv->contact)
-    {
-      applet = applet->next;
       break;
+
+    if (!fetched)
+    {
+      home_applets = osso_abook_settings_get_home_applets();
+      fetched = TRUE;
     }
 
     for (l = home_applets; l; l = l->next)
@@ -304,8 +620,8 @@ idle_update_applets(gpointer user_data)
       }
     }
 
-    applets = g_list_delete_link(applets, applet);
-    applet = applets;
+    g_queue_unlink(&applets, applet);
+    priv->pending = FALSE;
   }
 
   if (removed)
@@ -320,11 +636,196 @@ idle_update_applets(gpointer user_data)
 static void
 update_applets(OssoABookHomeApplet *applet)
 {
-  if (!g_list_find(applets, applet))
-    applets = g_list_prepend(applets, applet);
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+
+  if (!priv->pending)
+  {
+    g_queue_push_head_link(&applets, &priv->pending_link);
+    priv->pending = TRUE;
+  }
 
   if (!idle_update_id)
-    idle_update_id = g_idle_add(idle_update_applets, NULL);
+  {
+    idle_update_id = osso_abook_home_wakeups_idle_add(
+        OSSO_ABOOK_HOME_WAKEUP_UPDATE_APPLETS, idle_update_applets, NULL);
+  }
+}
+
+/* HDShortcuts creates and destroys the applets from its own GConf notify,
+ * a batch stops waiting for them after this */
+#define SHORTCUTS_BATCH_TIMEOUT 10
+
+/* a settings write that adds or removes applets. It holds a subscription
+ * freeze until every applet in it has been created or disposed, so they all
+ * land in one filter update. */
+struct _OssoABookHomeShortcutBatch
+{
+  GHashTable *uids;
+  guint timeout_id;
+};
+
+typedef struct _OssoABookHomeShortcutBatch OssoABookHomeShortcutBatch;
+
+static GSList *shortcut_batches = NULL;
+
+static OssoABookHomeShortcutBatch *
+shortcut_batch_new()
+{
+  OssoABookHomeShortcutBatch *batch = g_slice_new0(OssoABookHomeShortcutBatch);
+
+  batch->uids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  shortcut_batches = g_slist_prepend(shortcut_batches, batch);
+  osso_abook_home_aggregator_freeze_subscriptions();
+
+  return batch;
+}
+
+static void
+shortcut_batch_finish(OssoABookHomeShortcutBatch *batch)
+{
+  shortcut_batches = g_slist_remove(shortcut_batches, batch);
+
+  if (batch->timeout_id)
+    g_source_remove(batch->timeout_id);
+
+  g_hash_table_destroy(batch->uids);
+  g_slice_free(OssoABookHomeShortcutBatch, batch);
+  osso_abook_home_aggregator_thaw_subscriptions();
+}
+
+static gboolean
+shortcut_batch_timeout_cb(gpointer user_data)
+{
+  OssoABookHomeShortcutBatch *batch = user_data;
+
+  g_warning("%s: %u applets were neither created nor disposed in time",
+            __FUNCTION__, g_hash_table_size(batch->uids));
+  batch->timeout_id = 0;
+  shortcut_batch_finish(batch);
+
+  return FALSE;
+}
+
+/* the applet for uid got created or disposed */
+static void
+shortcut_done(const char *uid)
+{
+  GSList *l = shortcut_batches;
+
+  while (l)
+  {
+    OssoABookHomeShortcutBatch *batch = l->data;
+
+    l = l->next;
+
+    if (g_hash_table_remove(batch->uids, uid) &&
+        !g_hash_table_size(batch->uids))
+    {
+      shortcut_batch_finish(batch);
+    }
+  }
+}
+
+static GSList *
+find_shortcut(GSList *home_applets, const char *uid)
+{
+  GSList *l;
+
+  for (l = home_applets; l; l = l->next)
+  {
+    if (g_str_has_prefix(l->data, OSSO_ABOOK_HOME_APPLET_PREFIX) &&
+        !strcmp((const char *)l->data + strlen(OSSO_ABOOK_HOME_APPLET_PREFIX),
+                uid))
+    {
+      break;
+    }
+  }
+
+  return l;
+}
+
+static guint
+update_shortcuts(const char * const *uids, gboolean add, GError **error)
+{
+  GConfClient *gconf = gconf_client_get_default();
+  OssoABookHomeShortcutBatch *batch;
+  GError *local_error = NULL;
+  GSList *home_applets;
+  guint changed = 0;
+
+  home_applets = gconf_client_get_list(gconf, OSSO_ABOOK_HOME_APPLETS_GCONF_KEY,
+                                       GCONF_VALUE_STRING, &local_error);
+
+  if (local_error)
+  {
+    g_propagate_error(error, local_error);
+    g_object_unref(gconf);
+
+    return 0;
+  }
+
+  batch = shortcut_batch_new();
+
+  for (; uids && *uids; uids++)
+  {
+    GSList *l;
+
+    if (!**uids)
+      continue;
+
+    l = find_shortcut(home_applets, *uids);
+
+    if (add && !l)
+    {
+      home_applets = g_slist_append(
+          home_applets, g_strconcat(OSSO_ABOOK_HOME_APPLET_PREFIX, *uids,
+                                    NULL));
+      g_hash_table_insert(batch->uids, g_strdup(*uids), NULL);
+    }
+    else if (!add && l)
+    {
+      g_free(l->data);
+      home_applets = g_slist_delete_link(home_applets, l);
+      g_hash_table_insert(batch->uids, g_strdup(*uids), NULL);
+    }
+  }
+
+  /* every applet the write creates or destroys lands in one filter update,
+   * which the aggregator answers with a single contacts-added pass. The
+   * timeout only covers applets HDShortcuts never acts on. */
+  changed = g_hash_table_size(batch->uids);
+
+  if (changed &&
+      gconf_client_set_list(gconf, OSSO_ABOOK_HOME_APPLETS_GCONF_KEY,
+                            GCONF_VALUE_STRING, home_applets, error))
+  {
+    batch->timeout_id = osso_abook_home_wakeups_timeout_add_seconds(
+        OSSO_ABOOK_HOME_WAKEUP_UPDATE_APPLETS, SHORTCUTS_BATCH_TIMEOUT,
+        shortcut_batch_timeout_cb, batch);
+  }
+  else
+  {
+    shortcut_batch_finish(batch);
+    changed = 0;
+  }
+
+  g_slist_free_full(home_applets, g_free);
+  g_object_unref(gconf);
+
+  return changed;
+}
+
+guint
+osso_abook_home_applet_add_shortcuts(const char * const *uids, GError **error)
+{
+  return update_shortcuts(uids, TRUE, error);
+}
+
+guint
+osso_abook_home_applet_remove_shortcuts(const char * const *uids,
+                                        GError **error)
+{
+  return update_shortcuts(uids, FALSE, error);
 }
 
 static void
@@ -371,12 +872,13 @@ contacts_added_cb(OssoABookRoster *roster, OssoABookContact **contacts,
 }
 
 static void
-aggregator_ready_cb(OssoABookWaitable *waitable, const GError *error,
-                    gpointer user_data)
+aggregator_attach_cb(OssoABookAggregator *aggregator, gpointer user_data)
 {
   OssoABookHomeApplet *applet = user_data;
   OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
 
+  priv->aggregator = aggregator;
+
   priv->contacts_removed_id =
     g_signal_connect(priv->aggregator, "contacts-removed",
                      G_CALLBACK(contacts_removed_cb), applet);
@@ -389,67 +891,38 @@ aggregator_ready_cb(OssoABookWaitable *waitable, const GError *error,
 }
 
 static void
-create_aggregator(OssoABookHomeApplet *applet)
+aggregator_detach_cb(OssoABookAggregator *aggregator, gpointer user_data)
 {
-  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  OssoABookHomeAppletPrivate *priv = PRIVATE(user_data);
 
-  if (!aggregator)
+  if (priv->contacts_removed_id)
   {
-    aggregator = OSSO_ABOOK_AGGREGATOR(osso_abook_aggregator_new(NULL, NULL));
-    osso_abook_aggregator_add_filter(
-      aggregator, OSSO_ABOOK_CONTACT_FILTER(get_contact_subscriptions()));
-    osso_abook_roster_start(OSSO_ABOOK_ROSTER(aggregator));
+    g_signal_handler_disconnect(priv->aggregator, priv->contacts_removed_id);
+    priv->contacts_removed_id = 0;
   }
 
-  priv->aggregator = aggregator;
-  g_object_weak_ref(G_OBJECT(aggregator), aggregator_weak_notify, applet);
-  osso_abook_waitable_call_when_ready(OSSO_ABOOK_WAITABLE(aggregator),
-                                      aggregator_ready_cb, applet, NULL);
-}
-
-static gboolean
-respawn_timeout_cb(gpointer user_data)
-{
-  respawn_timeout_id = 0;
-  respawn_count = 0;
-
-  return FALSE;
-}
-
-static gboolean
-respawn_cb(gpointer user_data)
-{
-  OssoABookHomeApplet *applet = user_data;
-  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
-
-  if (respawn_timeout_id)
-    g_source_remove(respawn_timeout_id);
-
-  respawn_timeout_id = g_timeout_add(60000, respawn_timeout_cb, NULL);
-  priv->respawn_id = 0;
-  create_aggregator(applet);
+  if (priv->contacts_added_id)
+  {
+    g_signal_handler_disconnect(priv->aggregator, priv->contacts_added_id);
+    priv->contacts_added_id = 0;
+  }
 
-  return FALSE;
+  priv->aggregator = NULL;
 }
 
 static void
-aggregator_weak_notify(void *data, GObject *where_the_object_was)
+applet_memory_usage_cb(gsize *sizes, gpointer user_data)
 {
-  OssoABookHomeAppletPrivate *priv = PRIVATE(data);
-
-  if ((GObject *)priv->aggregator == where_the_object_was)
-  {
-    osso_abook_roster_manager_stop(osso_abook_roster_manager_get_default());
-
-    priv->aggregator = NULL;
-    priv->contacts_removed_id = 0;
-    priv->contacts_added_id = 0;
-
-    if (priv->respawn_id)
-      g_source_remove(priv->respawn_id);
-
-    priv->respawn_id = g_timeout_add(2500, respawn_cb, data);
-  }
+  OssoABookHomeAppletPrivate *priv = PRIVATE(user_data);
+
+  sizes[OSSO_ABOOK_HOME_MEMORY_AVATAR] +=
+    osso_abook_home_memory_surface_size(priv->avatar_image);
+  osso_abook_home_memory_add_surface(sizes, OSSO_ABOOK_HOME_MEMORY_AVATAR,
+                                     priv->avatar_native);
+  sizes[OSSO_ABOOK_HOME_MEMORY_LABEL] +=
+    osso_abook_home_name_renderer_get_footprint(priv->name);
+  sizes[OSSO_ABOOK_HOME_MEMORY_WIDGETS] +=
+    osso_abook_home_memory_widget_size(GTK_WIDGET(user_data));
 }
 
 static void
@@ -459,40 +932,22 @@ osso_abook_home_applet_dispose(GObject *object)
   OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
 
   remove_applet(applet);
-
-  if (priv->respawn_id)
-  {
-    g_source_remove(priv->respawn_id);
-    priv->respawn_id = 0;
-  }
+  osso_abook_home_startup_remove(HD_HOME_PLUGIN_ITEM(applet));
+  osso_abook_home_memory_remove(applet_memory_usage_cb, applet);
+  osso_abook_home_aggregator_remove_client(applet);
 
   if (priv->aggregator)
-  {
-    g_object_weak_unref(G_OBJECT(priv->aggregator), aggregator_weak_notify,
-                        applet);
-
-    if (priv->contacts_removed_id)
-    {
-      g_signal_handler_disconnect(priv->aggregator, priv->contacts_removed_id);
-      priv->contacts_removed_id = 0;
-    }
-
-    if (priv->contacts_added_id)
-    {
-      g_signal_handler_disconnect(priv->aggregator, priv->contacts_added_id);
-      priv->contacts_added_id = 0;
-    }
-
-    priv->aggregator = NULL;
-  }
+    aggregator_detach_cb(priv->aggregator, applet);
 
   update_contact(applet, NULL);
-  osso_abook_contact_subscriptions_remove(get_contact_subscriptions(),
-                                          priv->uid);
+  osso_abook_home_aggregator_unsubscribe(priv->uid);
+  shortcut_done(priv->uid);
+
+  drop_avatar_native(priv);
 
   if (priv->avatar_image)
   {
-    g_object_unref(priv->avatar_image);
+    cairo_surface_destroy(priv->avatar_image);
     priv->avatar_image = NULL;
   }
 
@@ -506,10 +961,77 @@ osso_abook_home_applet_finalize(GObject *object)
   OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
 
   g_free(priv->uid);
+  osso_abook_home_name_renderer_free(priv->name);
 
   G_OBJECT_CLASS(osso_abook_home_applet_parent_class)->finalize(object);
 }
 
+static void
+update_style(OssoABookHomeApplet *applet);
+
+/* the widgets behind the frame, the name and the presence icon */
+static void
+build_widgets(OssoABookHomeApplet *applet)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  GtkWidget *event_box;
+  GtkWidget *align;
+  GtkWidget *hbox;
+
+  priv->fixed = gtk_fixed_new();
+  gtk_container_add(GTK_CONTAINER(applet), priv->fixed);
+
+  event_box = gtk_event_box_new();
+  gtk_event_box_set_visible_window(GTK_EVENT_BOX(event_box), FALSE);
+  gtk_fixed_put(GTK_FIXED(priv->fixed), event_box, 0, 0);
+  gtk_widget_set_size_request(event_box, OSSO_ABOOK_HOME_THEME_TILE_WIDTH,
+                              OSSO_ABOOK_HOME_THEME_TILE_HEIGHT);
+
+  g_signal_connect(event_box, "button-press-event",
+                   G_CALLBACK(button_press_event_cb), applet);
+  g_signal_connect(event_box, "button-release-event",
+                   G_CALLBACK(button_release_event_cb), applet);
+  g_signal_connect(event_box, "leave-notify-event",
+                   G_CALLBACK(leave_notify_event_cb), applet);
+
+  align = gtk_alignment_new(0.5, 0.5, 0.0, 0.0);
+  gtk_fixed_put(GTK_FIXED(priv->fixed), align,
+                OSSO_ABOOK_HOME_THEME_LABEL_X, OSSO_ABOOK_HOME_THEME_LABEL_Y);
+  gtk_widget_set_size_request(align, OSSO_ABOOK_HOME_THEME_LABEL_WIDTH,
+                              OSSO_ABOOK_HOME_THEME_LABEL_HEIGHT);
+
+  hbox = gtk_hbox_new(FALSE, 8);
+  gtk_container_add(GTK_CONTAINER(align), hbox);
+
+  /* an empty no-window placeholder, the icon itself comes from the atlas */
+  priv->presence_icon = gtk_fixed_new();
+  gtk_widget_set_size_request(priv->presence_icon,
+                              OSSO_ABOOK_HOME_PRESENCE_ATLAS_ICON_SIZE,
+                              OSSO_ABOOK_HOME_PRESENCE_ATLAS_ICON_SIZE);
+  gtk_box_pack_start(GTK_BOX(hbox), priv->presence_icon, FALSE, FALSE, 0);
+  gtk_widget_set_no_show_all(priv->presence_icon, TRUE);
+
+  priv->name = osso_abook_home_name_renderer_new();
+  priv->name_area = gtk_fixed_new();
+  gtk_box_pack_start(GTK_BOX(hbox), priv->name_area, TRUE, TRUE, 0);
+
+  gtk_widget_show_all(GTK_WIDGET(priv->fixed));
+}
+
+/* until this runs, the applet only holds its UID and subscription, so an
+ * applet on another view costs neither widgets nor theme work */
+static void
+finish_startup(HDHomePluginItem *item)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(item);
+
+  build_widgets(OSSO_ABOOK_HOME_APPLET(item));
+  update_style(OSSO_ABOOK_HOME_APPLET(item));
+  osso_abook_home_aggregator_add_client(aggregator_attach_cb,
+                                        aggregator_detach_cb, item);
+  osso_abook_home_memory_add_applet(priv->uid, applet_memory_usage_cb, item);
+}
+
 static void
 osso_abook_home_applet_constructed(GObject *object)
 {
@@ -533,8 +1055,12 @@ osso_abook_home_applet_constructed(GObject *object)
     priv->uid = plugin_id;
   }
 
-  osso_abook_contact_subscriptions_add(get_contact_subscriptions(), priv->uid);
-  create_aggregator(applet);
+  osso_abook_home_trace_applet(priv->uid);
+  /* subscribe right away, so the aggregator loads every contact we will
+   * ever show in one go, even for applets that are finished later */
+  osso_abook_home_aggregator_subscribe(priv->uid);
+  shortcut_done(priv->uid);
+  osso_abook_home_startup_add(HD_HOME_PLUGIN_ITEM(applet), finish_startup);
 }
 
 static void
@@ -576,34 +1102,17 @@ osso_abook_home_applet_show(GtkWidget *widget)
     GTK_WIDGET_CLASS(osso_abook_home_applet_parent_class)->show(widget);
 }
 
-static void
-create_new_avatar_mask(GdkWindow *window)
-{
-  cairo_t *cr = gdk_cairo_create(window);
-  cairo_surface_t *surface;
-
-  surface = cairo_surface_create_similar(
-      cairo_get_target(cr),
-      CAIRO_CONTENT_ALPHA,
-      cairo_image_surface_get_width(avatar_mask),
-      cairo_image_surface_get_height(avatar_mask));
-  cairo_destroy(cr);
-
-  cr = cairo_create(surface);
-  cairo_set_source_surface(cr, avatar_mask, 0.0, 0.0);
-  cairo_paint(cr);
-  cairo_destroy(cr);
-  cairo_surface_destroy(avatar_mask);
-  avatar_mask = surface;
-}
-
 static gboolean
 osso_abook_home_applet_expose_event(GtkWidget *widget, GdkEventExpose *event)
 {
   OssoABookHomeApplet *applet = OSSO_ABOOK_HOME_APPLET(widget);
   OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
   cairo_t *cr = gdk_cairo_create(widget->window);
+  cairo_surface_t *avatar;
+  cairo_surface_t *frame;
+  gboolean rv;
 
+  osso_abook_home_wakeups_count(OSSO_ABOOK_HOME_WAKEUP_EXPOSE);
   gdk_cairo_region(cr, event->region);
   cairo_clip(cr);
 
@@ -614,95 +1123,108 @@ osso_abook_home_applet_expose_event(GtkWidget *widget, GdkEventExpose *event)
 
   cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
   cairo_paint(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 
-  if (cairo_surface_get_type(avatar_mask) == CAIRO_SURFACE_TYPE_IMAGE)
-    create_new_avatar_mask(widget->window);
+  avatar = get_avatar_native(applet);
 
-  if (priv->avatar_image && avatar_mask)
+  if (avatar)
   {
-    gdk_cairo_set_source_pixbuf(cr, priv->avatar_image, 8.0, 8.0);
-    cairo_mask_surface(cr, avatar_mask, 8.0, 8.0);
+    cairo_set_source_surface(cr, avatar, OSSO_ABOOK_HOME_THEME_AVATAR_X,
+                             OSSO_ABOOK_HOME_THEME_AVATAR_Y);
+    cairo_paint(cr);
+  }
+
+  frame = osso_abook_home_theme_get_frame(widget->window, priv->pressed);
+
+  if (frame)
+  {
+    cairo_set_source_surface(cr, frame, 0.0, 0.0);
+    cairo_paint(cr);
   }
 
   cairo_destroy(cr);
 
-  return GTK_WIDGET_CLASS(osso_abook_home_applet_parent_class)->expose_event(
-           widget, event);
-}
+  rv = GTK_WIDGET_CLASS(osso_abook_home_applet_parent_class)->expose_event(
+      widget, event);
 
-static GdkPixbuf *
-load_pixbuf(GtkSettings *settings, gchar *pixmap_file)
-{
-  gchar *filename = gtk_rc_find_pixmap_in_path(settings, NULL, pixmap_file);
-  GdkPixbuf *pixbuf;
-  GError *error = NULL;
+  /* presence and name are painted on top of the frame, from the shared
+   * atlas and the cached name bitmap, in the areas reserved for them */
+  cr = gdk_cairo_create(widget->window);
+  gdk_cairo_region(cr, event->region);
+  cairo_clip(cr);
+
+  if (priv->presence_index >= 0 && GTK_WIDGET_VISIBLE(priv->presence_icon))
+  {
+    GtkAllocation *allocation = &priv->presence_icon->allocation;
+
+    osso_abook_home_presence_atlas_draw(
+      cr, priv->presence_index,
+      allocation->x +
+      (allocation->width - OSSO_ABOOK_HOME_PRESENCE_ATLAS_ICON_SIZE) / 2,
+      allocation->y +
+      (allocation->height - OSSO_ABOOK_HOME_PRESENCE_ATLAS_ICON_SIZE) / 2);
+  }
+
+  if (priv->contact)
+  {
+    GtkAllocation *allocation = &priv->name_area->allocation;
 
-  g_return_val_if_fail(NULL != filename, NULL);
+    osso_abook_home_name_renderer_draw(priv->name, widget, cr,
+                                       get_name_max_width(priv),
+                                       allocation->x, allocation->y);
+  }
 
-  pixbuf = gdk_pixbuf_new_from_file(filename, &error);
+  cairo_destroy(cr);
 
-  if (error)
+  /* first paint of the active frame after a touch-down, push it to the
+   * server so the sample covers everything up to the compositor */
+  if (priv->press_time)
   {
-    g_warning("%s: %s", __FUNCTION__, error->message);
-    g_clear_error(&error);
+    gdk_display_flush(gtk_widget_get_display(widget));
+    osso_abook_home_stats_add_latency(
+      OSSO_ABOOK_HOME_LATENCY_PRESS, g_get_monotonic_time() - priv->press_time);
+    priv->press_time = 0;
   }
 
-  g_free(filename);
+  return rv;
+}
+
+static void
+update_style(OssoABookHomeApplet *applet)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  GtkWidget *widget = GTK_WIDGET(applet);
 
-  return pixbuf;
+  osso_abook_home_theme_update(widget);
+  osso_abook_home_name_renderer_invalidate(priv->name);
+  drop_avatar_native(priv);
+
+  if (priv->contact)
+    update_name_size(applet);
+
+  gtk_widget_queue_draw(widget);
 }
 
+/* placeholders have nothing styled yet, finish_startup() catches up */
 static void
 osso_abook_home_applet_style_set(GtkWidget *widget, GtkStyle *previous_style)
 {
-  OssoABookHomeApplet *applet = OSSO_ABOOK_HOME_APPLET(widget);
-  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
   GtkWidgetClass *widget_class =
     GTK_WIDGET_CLASS(osso_abook_home_applet_parent_class);
-  gchar *filename;
-  GtkStyle *new_style;
 
   if (widget_class->style_set)
     widget_class->style_set(widget, previous_style);
 
-  new_style = gtk_widget_get_style(widget);
-
-  if (new_style != style)
-  {
-    GtkSettings *settings;
-
-    style = new_style;
-    settings = gtk_settings_get_default();
-
-    if (frame_pixbuf)
-      g_object_unref(frame_pixbuf);
-
-    frame_pixbuf = load_pixbuf(settings, "ContactsAppletFrame.png");
-
-    g_assert(GDK_IS_PIXBUF(frame_pixbuf));
-
-    if (frame_active_pixbuf)
-      g_object_unref(frame_active_pixbuf);
-
-    frame_active_pixbuf = load_pixbuf(settings,
-                                      "ContactsAppletFrameActive.png");
-
-    g_assert(GDK_IS_PIXBUF(frame_active_pixbuf));
-
-    if (avatar_mask)
-      cairo_surface_destroy(avatar_mask);
-
-    filename = gtk_rc_find_pixmap_in_path(settings, NULL,
-                                          "ContactsAppletMask.png");
-    avatar_mask = cairo_image_surface_create_from_png(filename);
-
-    g_assert(avatar_mask != NULL);
+  if (PRIVATE(widget)->fixed)
+    update_style(OSSO_ABOOK_HOME_APPLET(widget));
+}
 
-    g_free(filename);
-  }
+static void
+osso_abook_home_applet_unrealize(GtkWidget *widget)
+{
+  drop_avatar_native(PRIVATE(widget));
 
-  gtk_image_set_from_pixbuf(GTK_IMAGE(priv->image), frame_pixbuf);
-  gtk_widget_queue_draw(widget);
+  GTK_WIDGET_CLASS(osso_abook_home_applet_parent_class)->unrealize(widget);
 }
 
 static void
@@ -716,20 +1238,45 @@ osso_abook_home_applet_class_init(OssoABookHomeAppletClass *klass)
   object_class->constructed = osso_abook_home_applet_constructed;
 
   widget_class->style_set = osso_abook_home_applet_style_set;
+  widget_class->unrealize = osso_abook_home_applet_unrealize;
   widget_class->screen_changed = osso_abook_home_applet_screen_changed;
   widget_class->show = osso_abook_home_applet_show;
   widget_class->expose_event = osso_abook_home_applet_expose_event;
 
-  osso_abook_set_backend_died_func(abook_backend_died_cd, NULL);
+  osso_abook_home_theme_install_style_properties(widget_class);
+}
+
+/* both frames have the same size, so flipping between them is a redraw of
+ * the area where they differ, without any size negotiation */
+static void
+set_pressed(OssoABookHomeApplet *applet, gboolean pressed)
+{
+  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
+  GdkRectangle damage;
+
+  priv->press_time = 0;
+
+  if (priv->pressed == pressed)
+    return;
+
+  priv->pressed = pressed;
+  osso_abook_home_theme_get_frame_damage(&damage);
+
+  if (!damage.width || !damage.height)
+    return;
+
+  if (pressed)
+    priv->press_time = g_get_monotonic_time();
+
+  gtk_widget_queue_draw_area(GTK_WIDGET(applet), damage.x, damage.y,
+                             damage.width, damage.height);
 }
 
 static gboolean
 button_press_event_cb(GtkWidget *self, GdkEventButton *event,
                       OssoABookHomeApplet *applet)
 {
-  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
-
-  gtk_image_set_from_pixbuf(GTK_IMAGE(priv->image), frame_active_pixbuf);
+  set_pressed(applet, TRUE);
 
   return TRUE;
 }
@@ -744,7 +1291,7 @@ button_release_event_cb(GtkWidget *self, GdkEventButton *event,
   if (dialog)
     return FALSE;
 
-  gtk_image_set_from_pixbuf(GTK_IMAGE(priv->image), frame_pixbuf);
+  set_pressed(applet, FALSE);
   starter = osso_abook_touch_contact_starter_new_with_contact(
       NULL, priv->contact);
 
@@ -761,9 +1308,7 @@ static gboolean
 leave_notify_event_cb(GtkWidget *self, GdkEventCrossing *event,
                       OssoABookHomeApplet *applet)
 {
-  OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
-
-  gtk_image_set_from_pixbuf(GTK_IMAGE(priv->image), frame_pixbuf);
+  set_pressed(applet, FALSE);
 
   return FALSE;
 }
@@ -772,48 +1317,11 @@ static void
 osso_abook_home_applet_init(OssoABookHomeApplet *applet)
 {
   OssoABookHomeAppletPrivate *priv = PRIVATE(applet);
-  GtkWidget *event_box;
-  GtkWidget *align;
-  GtkWidget *hbox;
 
+  priv->pending_link.data = applet;
+  priv->presence_index = -1;
   gtk_widget_add_events(GTK_WIDGET(applet), GDK_BUTTON_PRESS_MASK);
   gtk_widget_set_app_paintable(GTK_WIDGET(applet), TRUE);
 
   osso_abook_home_applet_screen_changed(GTK_WIDGET(applet), NULL);
-
-  priv->fixed = gtk_fixed_new();
-  gtk_container_add(GTK_CONTAINER(applet), priv->fixed);
-
-  priv->image = gtk_image_new();
-  gtk_fixed_put(GTK_FIXED(priv->fixed), priv->image, 0, 0);
-
-  event_box = gtk_event_box_new();
-  gtk_event_box_set_visible_window(GTK_EVENT_BOX(event_box), FALSE);
-  gtk_fixed_put(GTK_FIXED(priv->fixed), event_box, 0, 0);
-  gtk_widget_set_size_request(event_box, 144, 178);
-
-  g_signal_connect(event_box, "button-press-event",
-                   G_CALLBACK(button_press_event_cb), applet);
-  g_signal_connect(event_box, "button-release-event",
-                   G_CALLBACK(button_release_event_cb), applet);
-  g_signal_connect(event_box, "leave-notify-event",
-                   G_CALLBACK(leave_notify_event_cb), applet);
-
-  align = gtk_alignment_new(0.5, 0.5, 0.0, 0.0);
-  gtk_fixed_put(GTK_FIXED(priv->fixed), align, 12, 140);
-  gtk_widget_set_size_request(align, 120, 30);
-
-  hbox = gtk_hbox_new(FALSE, 8);
-  gtk_container_add(GTK_CONTAINER(align), hbox);
-
-  priv->presence_icon = osso_abook_presence_icon_new(NULL);
-  gtk_box_pack_start(GTK_BOX(hbox), priv->presence_icon, FALSE, FALSE, 0);
-  gtk_widget_set_no_show_all(priv->presence_icon, TRUE);
-
-  priv->label = gtk_label_new(NULL);
-  gtk_widget_set_name(priv->label, "hildon-shadow-label");
-  hildon_helper_set_logical_font(priv->label, "SmallSystemFont");
-  gtk_box_pack_start(GTK_BOX(hbox), priv->label, TRUE, TRUE, 0);
-
-  gtk_widget_show_all(GTK_WIDGET(priv->fixed));
 }
@@ -21,9 +21,14 @@
 #define __OSSO_ABOOK_HOME_APPLET_H_INCLUDED__
 
 #include <libhildondesktop/hd-home-plugin-item.h>
+#include <libosso-abook/osso-abook-contact.h>
 
 G_BEGIN_DECLS
 
+/* GConf list of applet ids, handled by HDShortcuts */
+#define OSSO_ABOOK_HOME_APPLETS_GCONF_KEY \
+                "/apps/osso-addressbook/home-applets"
+
 #define OSSO_ABOOK_TYPE_HOME_APPLET \
                 (osso_abook_home_applet_get_type ())
 #define OSSO_ABOOK_HOME_APPLET(obj) \
@@ -62,6 +67,24 @@ typedef struct _OssoABookHomeAppletClass OssoABookHomeAppletClass;
 GType
 osso_abook_home_applet_get_type(void) G_GNUC_CONST;
 
+const char *
+osso_abook_home_applet_get_contact_name(OssoABookContact *contact);
+
+/* takes over previous, which is reused when possible */
+cairo_surface_t *
+osso_abook_home_applet_load_avatar(OssoABookContact *contact,
+                                   cairo_surface_t *previous);
+
+/* add or remove applets for a NULL terminated list of contact UIDs with a
+ * single settings write and subscription update, returns how many applets
+ * were actually added or removed, 0 with error set if the write failed */
+guint
+osso_abook_home_applet_add_shortcuts(const char * const *uids, GError **error);
+
+guint
+osso_abook_home_applet_remove_shortcuts(const char * const *uids,
+                                        GError **error);
+
 G_END_DECLS
 
 #endif /* __OSSO_ABOOK_HOME_APPLET_H_INCLUDED__ */
@@ -0,0 +1,149 @@
+/*
+ * osso-abook-home-dbus.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "osso-abook-home-applet.h"
+#include "osso-abook-home-dbus.h"
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-stats.h"
+#include "osso-abook-home-wakeups.h"
+
+static void
+reply_report(DBusConnection *connection, DBusMessage *message, gchar *report)
+{
+  DBusMessage *reply = dbus_message_new_method_return(message);
+
+  g_message("%s", report);
+  dbus_message_append_args(reply, DBUS_TYPE_STRING, &report,
+                           DBUS_TYPE_INVALID);
+  dbus_connection_send(connection, reply, NULL);
+  dbus_message_unref(reply);
+  g_free(report);
+}
+
+static void
+reply_shortcuts(DBusConnection *connection, DBusMessage *message,
+                gboolean add)
+{
+  DBusMessage *reply;
+  DBusError error;
+  char **uids;
+  int n_uids;
+
+  dbus_error_init(&error);
+
+  if (dbus_message_get_args(message, &error,
+                            DBUS_TYPE_ARRAY, DBUS_TYPE_STRING, &uids, &n_uids,
+                            DBUS_TYPE_INVALID))
+  {
+    GError *gerror = NULL;
+    dbus_uint32_t changed;
+
+    /* the array is NULL terminated, as dbus_free_string_array needs it */
+    if (add)
+    {
+      changed = osso_abook_home_applet_add_shortcuts((const char **)uids,
+                                                     &gerror);
+    }
+    else
+    {
+      changed = osso_abook_home_applet_remove_shortcuts((const char **)uids,
+                                                        &gerror);
+    }
+
+    dbus_free_string_array(uids);
+
+    if (gerror)
+    {
+      reply = dbus_message_new_error(message, DBUS_ERROR_FAILED,
+                                     gerror->message);
+      g_error_free(gerror);
+    }
+    else
+    {
+      reply = dbus_message_new_method_return(message);
+      dbus_message_append_args(reply, DBUS_TYPE_UINT32, &changed,
+                               DBUS_TYPE_INVALID);
+    }
+  }
+  else
+  {
+    reply = dbus_message_new_error(message, error.name, error.message);
+    dbus_error_free(&error);
+  }
+
+  dbus_connection_send(connection, reply, NULL);
+  dbus_message_unref(reply);
+}
+
+DBusHandlerResult
+osso_abook_home_dbus_filter(DBusConnection *connection, DBusMessage *message,
+                            void *user_data)
+{
+  if (!dbus_message_has_path(message, OSSO_ABOOK_HOME_APPLET_DBUS_PATH))
+    return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+  if (dbus_message_is_method_call(message,
+                                  OSSO_ABOOK_HOME_APPLET_DBUS_INTERFACE,
+                                  "DumpMemoryUsage"))
+  {
+    reply_report(connection, message, osso_abook_home_memory_report());
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+  }
+
+  if (dbus_message_is_method_call(message,
+                                  OSSO_ABOOK_HOME_APPLET_DBUS_INTERFACE,
+                                  "DumpWakeups"))
+  {
+    reply_report(connection, message, osso_abook_home_wakeups_report());
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+  }
+
+  if (dbus_message_is_method_call(message,
+                                  OSSO_ABOOK_HOME_APPLET_DBUS_INTERFACE,
+                                  "DumpStats"))
+  {
+    reply_report(connection, message, osso_abook_home_stats_report());
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+  }
+
+  if (dbus_message_is_method_call(message,
+                                  OSSO_ABOOK_HOME_APPLET_DBUS_INTERFACE,
+                                  "AddShortcuts"))
+  {
+    reply_shortcuts(connection, message, TRUE);
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+  }
+
+  if (dbus_message_is_method_call(message,
+                                  OSSO_ABOOK_HOME_APPLET_DBUS_INTERFACE,
+                                  "RemoveShortcuts"))
+  {
+    reply_shortcuts(connection, message, FALSE);
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+  }
+
+  return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
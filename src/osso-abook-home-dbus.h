@@ -0,0 +1,42 @@
+/*
+ * osso-abook-home-dbus.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_DBUS_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_DBUS_H_INCLUDED__
+
+#include <dbus/dbus.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define OSSO_ABOOK_HOME_APPLET_DBUS_SERVICE "org.maemo.OssoABookHomeApplet"
+#define OSSO_ABOOK_HOME_APPLET_DBUS_PATH "/org/maemo/OssoABookHomeApplet"
+#define OSSO_ABOOK_HOME_APPLET_DBUS_INTERFACE "org.maemo.OssoABookHomeApplet"
+
+/* Connection filter answering the applet's method calls: DumpMemoryUsage,
+ * DumpWakeups and DumpStats reply with a report string, AddShortcuts and
+ * RemoveShortcuts take an array of contact UIDs and reply with how many
+ * applets changed. */
+DBusHandlerResult
+osso_abook_home_dbus_filter(DBusConnection *connection, DBusMessage *message,
+                            void *user_data);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_DBUS_H_INCLUDED__ */
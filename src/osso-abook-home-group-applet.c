@@ -0,0 +1,998 @@
+/*
+ * osso-abook-home-group-applet.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <gconf/gconf-client.h>
+#include <hildon/hildon.h>
+#include <libosso-abook/osso-abook-debug.h>
+#include <libosso-abook/osso-abook-touch-contact-starter.h>
+
+#include "osso-abook-home-aggregator.h"
+#include "osso-abook-home-applet.h"
+#include "osso-abook-home-group-applet.h"
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-name-renderer.h"
+#include "osso-abook-home-presence-atlas.h"
+#include "osso-abook-home-startup.h"
+#include "osso-abook-home-stats.h"
+#include "osso-abook-home-theme.h"
+#include "osso-abook-home-trace.h"
+#include "osso-abook-home-wakeups.h"
+
+#define DEFAULT_COLUMNS 4
+
+#define TILE_WIDTH OSSO_ABOOK_HOME_THEME_TILE_WIDTH
+#define TILE_HEIGHT OSSO_ABOOK_HOME_THEME_TILE_HEIGHT
+#define ICON_SIZE OSSO_ABOOK_HOME_PRESENCE_ATLAS_ICON_SIZE
+
+struct _OssoABookHomeGroupAppletCell
+{
+  gchar *uid;
+  OssoABookContact *contact;
+  cairo_surface_t *avatar_image;
+  gconstpointer avatar_token;
+  gint presence_index;
+  OssoABookHomeNameRenderer *name;
+};
+
+typedef struct _OssoABookHomeGroupAppletCell OssoABookHomeGroupAppletCell;
+
+struct _OssoABookHomeGroupAppletPrivate
+{
+  OssoABookAggregator *aggregator;
+  GConfClient *gconf;
+  gchar *name;
+  gchar *gconf_dir;
+  guint gconf_notify_id;
+  GArray *cells;
+  guint columns;
+  cairo_surface_t *surface;
+  gint pressed_cell;
+  gint64 press_time;
+  gulong contacts_removed_id;
+  gulong contacts_added_id;
+  gboolean has_alpha;
+  gboolean finished;
+};
+
+typedef struct _OssoABookHomeGroupAppletPrivate OssoABookHomeGroupAppletPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(
+  OssoABookHomeGroupApplet,
+  osso_abook_home_group_applet,
+  HD_TYPE_HOME_PLUGIN_ITEM
+);
+
+#define PRIVATE(group) \
+  ((OssoABookHomeGroupAppletPrivate *) \
+   osso_abook_home_group_applet_get_instance_private( \
+     (OssoABookHomeGroupApplet *)(group)))
+
+#define CELL(priv, index) \
+  (&g_array_index((priv)->cells, OssoABookHomeGroupAppletCell, (index)))
+
+static GtkWidget *dialog = NULL;
+
+static void
+get_cell_area(OssoABookHomeGroupAppletPrivate *priv, guint index,
+              GdkRectangle *area)
+{
+  area->x = (index % priv->columns) * TILE_WIDTH;
+  area->y = (index / priv->columns) * TILE_HEIGHT;
+  area->width = TILE_WIDTH;
+  area->height = TILE_HEIGHT;
+}
+
+static gint
+get_cell_at(OssoABookHomeGroupAppletPrivate *priv, gdouble x, gdouble y)
+{
+  guint column;
+  guint index;
+
+  if ((x < 0) || (y < 0))
+    return -1;
+
+  column = x / TILE_WIDTH;
+
+  if (column >= priv->columns)
+    return -1;
+
+  index = (guint)(y / TILE_HEIGHT) * priv->columns + column;
+
+  if (index >= priv->cells->len)
+    return -1;
+
+  return index;
+}
+
+static gint
+find_cell(GArray *cells, const char *uid)
+{
+  guint i;
+
+  for (i = 0; i < cells->len; i++)
+  {
+    OssoABookHomeGroupAppletCell *cell =
+      &g_array_index(cells, OssoABookHomeGroupAppletCell, i);
+
+    if (cell->uid && !strcmp(cell->uid, uid))
+      return i;
+  }
+
+  return -1;
+}
+
+static void
+draw_cell_label(GtkWidget *widget, cairo_t *cr,
+                OssoABookHomeGroupAppletCell *cell, GdkRectangle *area)
+{
+  int icon_width = 0;
+  int max_width;
+  int width;
+  int height;
+  double x;
+
+  if (cell->presence_index >= 0)
+    icon_width = ICON_SIZE + 8;
+
+  max_width = OSSO_ABOOK_HOME_THEME_LABEL_WIDTH - icon_width;
+  osso_abook_home_name_renderer_get_size(cell->name, widget, max_width,
+                                         &width, &height);
+
+  x = area->x + OSSO_ABOOK_HOME_THEME_LABEL_X +
+    (OSSO_ABOOK_HOME_THEME_LABEL_WIDTH - icon_width - width) / 2;
+
+  if (cell->presence_index >= 0)
+  {
+    osso_abook_home_presence_atlas_draw(
+      cr, cell->presence_index, x,
+      area->y + OSSO_ABOOK_HOME_THEME_LABEL_Y +
+      (OSSO_ABOOK_HOME_THEME_LABEL_HEIGHT - ICON_SIZE) / 2);
+    x += icon_width;
+  }
+
+  osso_abook_home_name_renderer_draw(
+    cell->name, widget, cr, max_width, x,
+    area->y + OSSO_ABOOK_HOME_THEME_LABEL_Y +
+    (OSSO_ABOOK_HOME_THEME_LABEL_HEIGHT - height) / 2);
+}
+
+static void
+paint_cell(OssoABookHomeGroupApplet *group, guint index)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  OssoABookHomeGroupAppletCell *cell = CELL(priv, index);
+  GtkWidget *widget = GTK_WIDGET(group);
+  GdkRectangle area;
+  cairo_t *cr;
+
+  if (!priv->surface)
+    return;
+
+  get_cell_area(priv, index, &area);
+  cr = cairo_create(priv->surface);
+  gdk_cairo_rectangle(cr, &area);
+  cairo_clip(cr);
+
+  if (priv->has_alpha)
+    cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 0.0);
+  else
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+  if (cell->contact)
+  {
+    cairo_surface_t *avatar_mask =
+      osso_abook_home_theme_get_avatar_mask(widget->window);
+    cairo_surface_t *frame =
+      osso_abook_home_theme_get_frame(widget->window,
+                                      priv->pressed_cell == (gint)index);
+
+    if (cell->avatar_image && avatar_mask)
+    {
+      cairo_set_source_surface(
+        cr, cell->avatar_image, area.x + OSSO_ABOOK_HOME_THEME_AVATAR_X,
+        area.y + OSSO_ABOOK_HOME_THEME_AVATAR_Y);
+      cairo_mask_surface(cr, avatar_mask,
+                         area.x + OSSO_ABOOK_HOME_THEME_AVATAR_X,
+                         area.y + OSSO_ABOOK_HOME_THEME_AVATAR_Y);
+    }
+
+    if (frame)
+    {
+      cairo_set_source_surface(cr, frame, area.x, area.y);
+      cairo_paint(cr);
+    }
+
+    draw_cell_label(widget, cr, cell, &area);
+  }
+
+  cairo_destroy(cr);
+}
+
+static gboolean
+ensure_surface(OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  GtkWidget *widget = GTK_WIDGET(group);
+  guint rows;
+  cairo_t *cr;
+  guint i;
+
+  if (priv->surface)
+    return TRUE;
+
+  if (!GTK_WIDGET_REALIZED(widget))
+    return FALSE;
+
+  rows = MAX(1, (priv->cells->len + priv->columns - 1) / priv->columns);
+
+  /* similar to the window, so exposes are plain server side copies */
+  cr = gdk_cairo_create(widget->window);
+  priv->surface = cairo_surface_create_similar(
+      cairo_get_target(cr),
+      priv->has_alpha ? CAIRO_CONTENT_COLOR_ALPHA : CAIRO_CONTENT_COLOR,
+      priv->columns * TILE_WIDTH, rows * TILE_HEIGHT);
+  cairo_destroy(cr);
+
+  for (i = 0; i < priv->cells->len; i++)
+    paint_cell(group, i);
+
+  return TRUE;
+}
+
+static void
+invalidate_surface(OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+
+  if (priv->surface)
+  {
+    cairo_surface_destroy(priv->surface);
+    priv->surface = NULL;
+  }
+
+  gtk_widget_queue_draw(GTK_WIDGET(group));
+}
+
+static void
+update_cell(OssoABookHomeGroupApplet *group, guint index)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  GdkRectangle area;
+
+  paint_cell(group, index);
+  get_cell_area(priv, index, &area);
+  gtk_widget_queue_draw_area(GTK_WIDGET(group), area.x, area.y, area.width,
+                             area.height);
+}
+
+/* the press state only changes the frame, so only the area where the two
+ * frames differ goes to the screen */
+static void
+set_pressed_cell(OssoABookHomeGroupApplet *group, gint index)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  gint previous = priv->pressed_cell;
+  GdkRectangle damage;
+  GdkRectangle area;
+
+  priv->press_time = 0;
+
+  if (previous == index)
+    return;
+
+  priv->pressed_cell = index;
+  osso_abook_home_theme_get_frame_damage(&damage);
+
+  if (previous >= 0)
+  {
+    paint_cell(group, previous);
+    get_cell_area(priv, previous, &area);
+    gtk_widget_queue_draw_area(GTK_WIDGET(group), area.x + damage.x,
+                               area.y + damage.y, damage.width,
+                               damage.height);
+  }
+
+  if (index >= 0)
+  {
+    /* the cell repaint is part of what the user waits for */
+    if (damage.width && damage.height)
+      priv->press_time = g_get_monotonic_time();
+
+    paint_cell(group, index);
+    get_cell_area(priv, index, &area);
+    gtk_widget_queue_draw_area(GTK_WIDGET(group), area.x + damage.x,
+                               area.y + damage.y, damage.width,
+                               damage.height);
+  }
+}
+
+static void
+contact_notify_avatar_image_cb(OssoABookContact *contact, GParamSpec *pspec,
+                               OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  guint i;
+
+  for (i = 0; i < priv->cells->len; i++)
+  {
+    OssoABookHomeGroupAppletCell *cell = CELL(priv, i);
+
+    /* same token, same image, nothing to do */
+    if ((cell->contact == contact) &&
+        (cell->avatar_token !=
+         osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(contact))))
+    {
+      cell->avatar_image =
+        osso_abook_home_applet_load_avatar(contact, cell->avatar_image);
+      cell->avatar_token =
+        osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(contact));
+      update_cell(group, i);
+    }
+  }
+}
+
+static void
+contact_notify_presence_type_cb(OssoABookContact *contact, GParamSpec *pspec,
+                                OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  gint presence_index = osso_abook_home_presence_atlas_lookup(
+      osso_abook_presence_get_icon_name(OSSO_ABOOK_PRESENCE(contact)));
+  guint i;
+
+  for (i = 0; i < priv->cells->len; i++)
+  {
+    OssoABookHomeGroupAppletCell *cell = CELL(priv, i);
+
+    if ((cell->contact == contact) &&
+        (cell->presence_index != presence_index))
+    {
+      cell->presence_index = presence_index;
+      update_cell(group, i);
+    }
+  }
+}
+
+/* same as for the single applet, only the name, avatar and presence are
+ * shown, a reset changing none of them must not repaint the cell */
+static void
+contact_reset_cb(OssoABookContact *contact, OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  const char *name = osso_abook_home_applet_get_contact_name(contact);
+  gconstpointer avatar_token =
+    osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(contact));
+  gint presence_index = osso_abook_home_presence_atlas_lookup(
+      osso_abook_presence_get_icon_name(OSSO_ABOOK_PRESENCE(contact)));
+  guint i;
+
+  for (i = 0; i < priv->cells->len; i++)
+  {
+    OssoABookHomeGroupAppletCell *cell = CELL(priv, i);
+    gboolean changed;
+
+    if (cell->contact != contact)
+      continue;
+
+    osso_abook_home_stats_count(OSSO_ABOOK_HOME_COUNTER_RESET);
+    changed = osso_abook_home_name_renderer_set_text(cell->name, name);
+
+    if (cell->avatar_token != avatar_token)
+    {
+      cell->avatar_image =
+        osso_abook_home_applet_load_avatar(contact, cell->avatar_image);
+      cell->avatar_token = avatar_token;
+      changed = TRUE;
+    }
+
+    if (cell->presence_index != presence_index)
+    {
+      cell->presence_index = presence_index;
+      changed = TRUE;
+    }
+
+    if (changed)
+      update_cell(group, i);
+    else
+      osso_abook_home_stats_count(OSSO_ABOOK_HOME_COUNTER_RESET_SKIPPED);
+  }
+}
+
+static void
+set_cell_contact(OssoABookHomeGroupApplet *group, guint index,
+                 OssoABookContact *contact)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  OssoABookHomeGroupAppletCell *cell = CELL(priv, index);
+
+  if (cell->contact == contact)
+    return;
+
+  if (cell->contact)
+  {
+    g_signal_handlers_disconnect_matched(
+      cell->contact, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, group);
+    g_object_unref(cell->contact);
+    cell->contact = NULL;
+  }
+
+  if (cell->avatar_image)
+  {
+    cairo_surface_destroy(cell->avatar_image);
+    cell->avatar_image = NULL;
+  }
+
+  cell->presence_index = -1;
+
+  if (contact)
+  {
+    cell->contact = g_object_ref(contact);
+    cell->avatar_image = osso_abook_home_applet_load_avatar(contact, NULL);
+    cell->avatar_token =
+      osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(contact));
+    cell->presence_index = osso_abook_home_presence_atlas_lookup(
+        osso_abook_presence_get_icon_name(OSSO_ABOOK_PRESENCE(contact)));
+    osso_abook_home_name_renderer_set_text(
+      cell->name, osso_abook_home_applet_get_contact_name(contact));
+
+    g_signal_connect(contact, "notify::avatar-image",
+                     G_CALLBACK(contact_notify_avatar_image_cb), group);
+    g_signal_connect(contact, "notify::presence-type",
+                     G_CALLBACK(contact_notify_presence_type_cb), group);
+    g_signal_connect(contact, "reset",
+                     G_CALLBACK(contact_reset_cb), group);
+    osso_abook_home_trace_watch_contact(contact);
+  }
+
+  update_cell(group, index);
+}
+
+static void
+resolve_cell(OssoABookHomeGroupApplet *group, guint index)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+
+  set_cell_contact(group, index,
+                   osso_abook_home_aggregator_lookup(CELL(priv, index)->uid));
+}
+
+static void
+clear_cell(OssoABookHomeGroupApplet *group,
+           OssoABookHomeGroupAppletCell *cell)
+{
+  if (cell->contact)
+  {
+    g_signal_handlers_disconnect_matched(
+      cell->contact, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, group);
+    g_object_unref(cell->contact);
+  }
+
+  if (cell->avatar_image)
+    cairo_surface_destroy(cell->avatar_image);
+
+  osso_abook_home_name_renderer_free(cell->name);
+  osso_abook_home_aggregator_unsubscribe(cell->uid);
+  g_free(cell->uid);
+  memset(cell, 0, sizeof(*cell));
+}
+
+static void
+contacts_removed_cb(OssoABookRoster *roster, const char **uids,
+                    OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+
+  for (; *uids; uids++)
+  {
+    guint i;
+
+    for (i = 0; i < priv->cells->len; i++)
+    {
+      OssoABookHomeGroupAppletCell *cell = CELL(priv, i);
+      const char *contact_uid = NULL;
+
+      if (cell->contact)
+      {
+        contact_uid = e_contact_get_const(E_CONTACT(cell->contact),
+                                          E_CONTACT_UID);
+      }
+
+      if (!strcmp(*uids, cell->uid) ||
+          (contact_uid && !strcmp(*uids, contact_uid)))
+      {
+        resolve_cell(group, i);
+      }
+    }
+  }
+}
+
+static void
+contacts_added_cb(OssoABookRoster *roster, OssoABookContact **contacts,
+                  OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  guint i;
+
+  for (i = 0; i < priv->cells->len; i++)
+  {
+    if (!CELL(priv, i)->contact)
+      resolve_cell(group, i);
+  }
+}
+
+static void
+aggregator_attach_cb(OssoABookAggregator *aggregator, gpointer user_data)
+{
+  OssoABookHomeGroupApplet *group = user_data;
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  guint i;
+
+  priv->aggregator = aggregator;
+
+  priv->contacts_removed_id =
+    g_signal_connect(priv->aggregator, "contacts-removed",
+                     G_CALLBACK(contacts_removed_cb), group);
+
+  priv->contacts_added_id =
+    g_signal_connect(priv->aggregator, "contacts-added",
+                     G_CALLBACK(contacts_added_cb), group);
+
+  for (i = 0; i < priv->cells->len; i++)
+    resolve_cell(group, i);
+}
+
+static void
+aggregator_detach_cb(OssoABookAggregator *aggregator, gpointer user_data)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(user_data);
+
+  if (priv->contacts_removed_id)
+  {
+    g_signal_handler_disconnect(priv->aggregator, priv->contacts_removed_id);
+    priv->contacts_removed_id = 0;
+  }
+
+  if (priv->contacts_added_id)
+  {
+    g_signal_handler_disconnect(priv->aggregator, priv->contacts_added_id);
+    priv->contacts_added_id = 0;
+  }
+
+  priv->aggregator = NULL;
+}
+
+static void
+load_members(OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  GArray *old_cells = priv->cells;
+  GSList *uids;
+  GSList *l;
+  gchar *key;
+  gint columns;
+  guint rows;
+  guint i;
+
+  key = g_strconcat(priv->gconf_dir, "/contacts", NULL);
+  uids = gconf_client_get_list(priv->gconf, key, GCONF_VALUE_STRING, NULL);
+  g_free(key);
+
+  key = g_strconcat(priv->gconf_dir, "/columns", NULL);
+  columns = gconf_client_get_int(priv->gconf, key, NULL);
+  g_free(key);
+
+  priv->columns = columns > 0 ? columns : DEFAULT_COLUMNS;
+  priv->cells = g_array_new(FALSE, TRUE, sizeof(OssoABookHomeGroupAppletCell));
+
+  for (l = uids; l; l = l->next)
+  {
+    OssoABookHomeGroupAppletCell cell = { .presence_index = -1 };
+    gint old_index;
+
+    if (find_cell(priv->cells, l->data) >= 0)
+      continue;
+
+    old_index = old_cells ? find_cell(old_cells, l->data) : -1;
+
+    /* members that stay keep their contact, avatar and subscription */
+    if (old_index >= 0)
+    {
+      OssoABookHomeGroupAppletCell *old_cell =
+        &g_array_index(old_cells, OssoABookHomeGroupAppletCell, old_index);
+
+      cell = *old_cell;
+      old_cell->uid = NULL;
+    }
+    else
+    {
+      cell.uid = g_strdup(l->data);
+      cell.name = osso_abook_home_name_renderer_new();
+      osso_abook_home_aggregator_subscribe(cell.uid);
+    }
+
+    g_array_append_val(priv->cells, cell);
+  }
+
+  g_slist_free_full(uids, g_free);
+
+  if (old_cells)
+  {
+    for (i = 0; i < old_cells->len; i++)
+    {
+      OssoABookHomeGroupAppletCell *cell =
+        &g_array_index(old_cells, OssoABookHomeGroupAppletCell, i);
+
+      if (cell->uid)
+        clear_cell(group, cell);
+    }
+
+    g_array_free(old_cells, TRUE);
+  }
+
+  rows = MAX(1, (priv->cells->len + priv->columns - 1) / priv->columns);
+  gtk_widget_set_size_request(GTK_WIDGET(group), priv->columns * TILE_WIDTH,
+                              rows * TILE_HEIGHT);
+  priv->pressed_cell = -1;
+  invalidate_surface(group);
+
+  if (priv->aggregator)
+  {
+    for (i = 0; i < priv->cells->len; i++)
+    {
+      if (!CELL(priv, i)->contact)
+        resolve_cell(group, i);
+    }
+  }
+}
+
+static void
+gconf_notify_cb(GConfClient *client, guint cnxn_id, GConfEntry *entry,
+                gpointer user_data)
+{
+  load_members(OSSO_ABOOK_HOME_GROUP_APPLET(user_data));
+}
+
+static void
+group_memory_usage_cb(gsize *sizes, gpointer user_data)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(user_data);
+  guint i;
+
+  for (i = 0; i < priv->cells->len; i++)
+  {
+    sizes[OSSO_ABOOK_HOME_MEMORY_AVATAR] +=
+      osso_abook_home_memory_surface_size(CELL(priv, i)->avatar_image);
+    sizes[OSSO_ABOOK_HOME_MEMORY_LABEL] +=
+      osso_abook_home_name_renderer_get_footprint(CELL(priv, i)->name);
+  }
+
+  sizes[OSSO_ABOOK_HOME_MEMORY_WIDGETS] +=
+    osso_abook_home_memory_widget_size(GTK_WIDGET(user_data));
+  osso_abook_home_memory_add_surface(sizes, OSSO_ABOOK_HOME_MEMORY_WIDGETS,
+                                     priv->surface);
+}
+
+static void
+osso_abook_home_group_applet_dispose(GObject *object)
+{
+  OssoABookHomeGroupApplet *group = OSSO_ABOOK_HOME_GROUP_APPLET(object);
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+
+  osso_abook_home_startup_remove(HD_HOME_PLUGIN_ITEM(group));
+  osso_abook_home_memory_remove(group_memory_usage_cb, group);
+  osso_abook_home_aggregator_remove_client(group);
+
+  if (priv->aggregator)
+    aggregator_detach_cb(priv->aggregator, group);
+
+  if (priv->gconf)
+  {
+    if (priv->gconf_notify_id)
+    {
+      gconf_client_notify_remove(priv->gconf, priv->gconf_notify_id);
+      priv->gconf_notify_id = 0;
+    }
+
+    g_object_unref(priv->gconf);
+    priv->gconf = NULL;
+  }
+
+  if (priv->cells)
+  {
+    guint i;
+
+    for (i = 0; i < priv->cells->len; i++)
+      clear_cell(group, CELL(priv, i));
+
+    g_array_free(priv->cells, TRUE);
+    priv->cells = NULL;
+  }
+
+  if (priv->surface)
+  {
+    cairo_surface_destroy(priv->surface);
+    priv->surface = NULL;
+  }
+
+  G_OBJECT_CLASS(osso_abook_home_group_applet_parent_class)->dispose(object);
+}
+
+static void
+osso_abook_home_group_applet_finalize(GObject *object)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(object);
+
+  g_free(priv->name);
+  g_free(priv->gconf_dir);
+
+  G_OBJECT_CLASS(osso_abook_home_group_applet_parent_class)->finalize(object);
+}
+
+static void
+update_style(OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  guint i;
+
+  osso_abook_home_theme_update(GTK_WIDGET(group));
+
+  for (i = 0; priv->cells && (i < priv->cells->len); i++)
+    osso_abook_home_name_renderer_invalidate(CELL(priv, i)->name);
+
+  invalidate_surface(group);
+}
+
+static void
+finish_startup(HDHomePluginItem *item)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(item);
+
+  priv->finished = TRUE;
+  update_style(OSSO_ABOOK_HOME_GROUP_APPLET(item));
+  osso_abook_home_aggregator_add_client(aggregator_attach_cb,
+                                        aggregator_detach_cb, item);
+  osso_abook_home_memory_add_applet(priv->name, group_memory_usage_cb, item);
+}
+
+static void
+osso_abook_home_group_applet_constructed(GObject *object)
+{
+  OssoABookHomeGroupApplet *group = OSSO_ABOOK_HOME_GROUP_APPLET(object);
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  gchar *plugin_id;
+
+  G_OBJECT_CLASS(osso_abook_home_group_applet_parent_class)->constructed(
+    object);
+
+  g_object_get(group, "plugin-id", &plugin_id, NULL);
+
+  if (g_str_has_prefix(plugin_id, OSSO_ABOOK_HOME_GROUP_APPLET_PREFIX))
+  {
+    priv->name = g_strdup(
+        plugin_id + strlen(OSSO_ABOOK_HOME_GROUP_APPLET_PREFIX));
+    g_free(plugin_id);
+  }
+  else
+  {
+    g_warning("%s is not a valid abook home group applet id", plugin_id);
+    priv->name = plugin_id;
+  }
+
+  priv->gconf = gconf_client_get_default();
+  priv->gconf_dir = g_strconcat(OSSO_ABOOK_HOME_GROUPS_GCONF_DIR, "/",
+                                priv->name, NULL);
+  priv->gconf_notify_id = gconf_client_notify_add(
+      priv->gconf, priv->gconf_dir, gconf_notify_cb, group, NULL, NULL);
+
+  load_members(group);
+  osso_abook_home_startup_add(HD_HOME_PLUGIN_ITEM(group), finish_startup);
+}
+
+static void
+osso_abook_home_group_applet_screen_changed(GtkWidget *widget,
+                                            GdkScreen *previous_screen)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(widget);
+  GdkScreen *screen;
+  GdkColormap *colormap;
+
+  if (previous_screen)
+  {
+    GTK_WIDGET_CLASS(osso_abook_home_group_applet_parent_class)->
+    screen_changed(widget, previous_screen);
+  }
+
+  screen = gtk_widget_get_screen(widget);
+  colormap = gdk_screen_get_rgba_colormap(screen);
+
+  if (colormap)
+    priv->has_alpha = TRUE;
+  else
+  {
+    colormap = gdk_screen_get_rgb_colormap(screen);
+    priv->has_alpha = FALSE;
+  }
+
+  gtk_widget_set_colormap(widget, colormap);
+}
+
+static void
+osso_abook_home_group_applet_style_set(GtkWidget *widget,
+                                       GtkStyle *previous_style)
+{
+  GtkWidgetClass *widget_class =
+    GTK_WIDGET_CLASS(osso_abook_home_group_applet_parent_class);
+
+  if (widget_class->style_set)
+    widget_class->style_set(widget, previous_style);
+
+  /* placeholders load the theme once finish_startup() runs */
+  if (PRIVATE(widget)->finished)
+    update_style(OSSO_ABOOK_HOME_GROUP_APPLET(widget));
+}
+
+static void
+osso_abook_home_group_applet_unrealize(GtkWidget *widget)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(widget);
+
+  if (priv->surface)
+  {
+    cairo_surface_destroy(priv->surface);
+    priv->surface = NULL;
+  }
+
+  GTK_WIDGET_CLASS(osso_abook_home_group_applet_parent_class)->unrealize(
+    widget);
+}
+
+static gboolean
+osso_abook_home_group_applet_expose_event(GtkWidget *widget,
+                                          GdkEventExpose *event)
+{
+  OssoABookHomeGroupApplet *group = OSSO_ABOOK_HOME_GROUP_APPLET(widget);
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  cairo_t *cr;
+
+  osso_abook_home_wakeups_count(OSSO_ABOOK_HOME_WAKEUP_EXPOSE);
+
+  if (!ensure_surface(group))
+    return FALSE;
+
+  cr = gdk_cairo_create(widget->window);
+  gdk_cairo_region(cr, event->region);
+  cairo_clip(cr);
+  cairo_set_source_surface(cr, priv->surface, 0.0, 0.0);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+
+  /* group presses repaint a cell too, so they have their own bucket */
+  if (priv->press_time)
+  {
+    gdk_display_flush(gtk_widget_get_display(widget));
+    osso_abook_home_stats_add_latency(
+      OSSO_ABOOK_HOME_LATENCY_GROUP_PRESS,
+      g_get_monotonic_time() - priv->press_time);
+    priv->press_time = 0;
+  }
+
+  return GTK_WIDGET_CLASS(osso_abook_home_group_applet_parent_class)->
+         expose_event(widget, event);
+}
+
+static gboolean
+osso_abook_home_group_applet_button_press_event(GtkWidget *widget,
+                                                GdkEventButton *event)
+{
+  OssoABookHomeGroupApplet *group = OSSO_ABOOK_HOME_GROUP_APPLET(widget);
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  gint index = get_cell_at(priv, event->x, event->y);
+
+  if ((index < 0) || !CELL(priv, index)->contact)
+    return FALSE;
+
+  set_pressed_cell(group, index);
+
+  return TRUE;
+}
+
+static gboolean
+osso_abook_home_group_applet_button_release_event(GtkWidget *widget,
+                                                  GdkEventButton *event)
+{
+  OssoABookHomeGroupApplet *group = OSSO_ABOOK_HOME_GROUP_APPLET(widget);
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+  gint index = priv->pressed_cell;
+  OssoABookContact *contact;
+  GtkWidget *starter;
+
+  if (index < 0)
+    return FALSE;
+
+  set_pressed_cell(group, -1);
+  contact = CELL(priv, index)->contact;
+
+  if (dialog || !contact || (get_cell_at(priv, event->x, event->y) != index))
+    return TRUE;
+
+  starter = osso_abook_touch_contact_starter_new_with_contact(NULL, contact);
+  dialog = osso_abook_touch_contact_starter_dialog_new(
+      NULL, OSSO_ABOOK_TOUCH_CONTACT_STARTER(starter));
+  g_object_add_weak_pointer(G_OBJECT(dialog), (gpointer *)&dialog);
+  gtk_widget_show(starter);
+  gtk_widget_show(dialog);
+
+  return TRUE;
+}
+
+static gboolean
+osso_abook_home_group_applet_leave_notify_event(GtkWidget *widget,
+                                                GdkEventCrossing *event)
+{
+  set_pressed_cell(OSSO_ABOOK_HOME_GROUP_APPLET(widget), -1);
+
+  return FALSE;
+}
+
+static void
+osso_abook_home_group_applet_class_init(OssoABookHomeGroupAppletClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
+
+  object_class->dispose = osso_abook_home_group_applet_dispose;
+  object_class->finalize = osso_abook_home_group_applet_finalize;
+  object_class->constructed = osso_abook_home_group_applet_constructed;
+
+  widget_class->style_set = osso_abook_home_group_applet_style_set;
+  widget_class->screen_changed = osso_abook_home_group_applet_screen_changed;
+  widget_class->unrealize = osso_abook_home_group_applet_unrealize;
+  widget_class->expose_event = osso_abook_home_group_applet_expose_event;
+  widget_class->button_press_event =
+    osso_abook_home_group_applet_button_press_event;
+  widget_class->button_release_event =
+    osso_abook_home_group_applet_button_release_event;
+  widget_class->leave_notify_event =
+    osso_abook_home_group_applet_leave_notify_event;
+
+  osso_abook_home_theme_install_style_properties(widget_class);
+}
+
+static void
+osso_abook_home_group_applet_init(OssoABookHomeGroupApplet *group)
+{
+  OssoABookHomeGroupAppletPrivate *priv = PRIVATE(group);
+
+  priv->pressed_cell = -1;
+  priv->columns = DEFAULT_COLUMNS;
+
+  gtk_widget_add_events(GTK_WIDGET(group),
+                        GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK |
+                        GDK_LEAVE_NOTIFY_MASK);
+  gtk_widget_set_app_paintable(GTK_WIDGET(group), TRUE);
+
+  osso_abook_home_group_applet_screen_changed(GTK_WIDGET(group), NULL);
+}
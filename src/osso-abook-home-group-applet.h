@@ -0,0 +1,78 @@
+/*
+ * osso-abook-home-group-applet.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_GROUP_APPLET_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_GROUP_APPLET_H_INCLUDED__
+
+#include <libhildondesktop/hd-home-plugin-item.h>
+
+G_BEGIN_DECLS
+
+/* GConf list of group applet ids, handled by HDShortcuts */
+#define OSSO_ABOOK_HOME_GROUP_APPLETS_GCONF_KEY \
+                "/apps/osso-addressbook/home-group-applets"
+
+/* group applet id is this prefix followed by the group name, the contact
+ * UIDs of the group are in the string list
+ * OSSO_ABOOK_HOME_GROUPS_GCONF_DIR/<group name>/contacts and the number of
+ * grid columns in the int OSSO_ABOOK_HOME_GROUPS_GCONF_DIR/<name>/columns */
+#define OSSO_ABOOK_HOME_GROUP_APPLET_PREFIX "osso-abook-group-applet-"
+#define OSSO_ABOOK_HOME_GROUPS_GCONF_DIR "/apps/osso-addressbook/home-groups"
+
+#define OSSO_ABOOK_TYPE_HOME_GROUP_APPLET \
+                (osso_abook_home_group_applet_get_type ())
+#define OSSO_ABOOK_HOME_GROUP_APPLET(obj) \
+                (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                 OSSO_ABOOK_TYPE_HOME_GROUP_APPLET, \
+                 OssoABookHomeGroupApplet))
+#define OSSO_ABOOK_HOME_GROUP_APPLET_CLASS(cls) \
+                (G_TYPE_CHECK_CLASS_CAST ((cls), \
+                 OSSO_ABOOK_TYPE_HOME_GROUP_APPLET, \
+                 OssoABookHomeGroupAppletClass))
+#define OSSO_ABOOK_IS_HOME_GROUP_APPLET(obj) \
+                (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+                 OSSO_ABOOK_TYPE_HOME_GROUP_APPLET))
+#define OSSO_ABOOK_IS_HOME_GROUP_APPLET_CLASS(obj) \
+                (G_TYPE_CHECK_CLASS_TYPE ((obj), \
+                 OSSO_ABOOK_TYPE_HOME_GROUP_APPLET))
+#define OSSO_ABOOK_HOME_GROUP_APPLET_GET_CLASS(obj) \
+                (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                 OSSO_ABOOK_TYPE_HOME_GROUP_APPLET, \
+                 OssoABookHomeGroupAppletClass))
+
+struct _OssoABookHomeGroupApplet
+{
+  HDHomePluginItem parent;
+};
+
+typedef struct _OssoABookHomeGroupApplet OssoABookHomeGroupApplet;
+
+struct _OssoABookHomeGroupAppletClass
+{
+  HDHomePluginItemClass parent_class;
+};
+
+typedef struct _OssoABookHomeGroupAppletClass OssoABookHomeGroupAppletClass;
+
+GType
+osso_abook_home_group_applet_get_type(void) G_GNUC_CONST;
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_GROUP_APPLET_H_INCLUDED__ */
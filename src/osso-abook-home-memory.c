@@ -0,0 +1,306 @@
+/*
+ * osso-abook-home-memory.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <cairo-xlib.h>
+
+#include <string.h>
+
+#include "osso-abook-home-memory.h"
+
+struct _OssoABookHomeMemorySource
+{
+  gchar *name;
+  gboolean applet;
+  OssoABookHomeMemoryFunc func;
+  gpointer user_data;
+};
+
+typedef struct _OssoABookHomeMemorySource OssoABookHomeMemorySource;
+
+static const char *category_names[OSSO_ABOOK_HOME_MEMORY_LAST] =
+{
+  "avatar",
+  "presence",
+  "label",
+  "widgets",
+  "frames",
+  "mask",
+  "roster",
+  "pixmaps"
+};
+
+static GList *sources = NULL;
+
+static void
+add_source(const char *name, gboolean applet, OssoABookHomeMemoryFunc func,
+           gpointer user_data)
+{
+  OssoABookHomeMemorySource *source;
+
+  g_return_if_fail(func != NULL);
+
+  source = g_slice_new(OssoABookHomeMemorySource);
+  source->name = g_strdup(name);
+  source->applet = applet;
+  source->func = func;
+  source->user_data = user_data;
+  sources = g_list_append(sources, source);
+}
+
+void
+osso_abook_home_memory_add_applet(const char *name,
+                                  OssoABookHomeMemoryFunc func,
+                                  gpointer user_data)
+{
+  add_source(name, TRUE, func, user_data);
+}
+
+void
+osso_abook_home_memory_add_shared(const char *name,
+                                  OssoABookHomeMemoryFunc func,
+                                  gpointer user_data)
+{
+  add_source(name, FALSE, func, user_data);
+}
+
+void
+osso_abook_home_memory_remove(OssoABookHomeMemoryFunc func,
+                              gpointer user_data)
+{
+  GList *l;
+
+  for (l = sources; l; l = l->next)
+  {
+    OssoABookHomeMemorySource *source = l->data;
+
+    if ((source->func == func) && (source->user_data == user_data))
+    {
+      sources = g_list_delete_link(sources, l);
+      g_free(source->name);
+      g_slice_free(OssoABookHomeMemorySource, source);
+      break;
+    }
+  }
+}
+
+static gsize
+get_total(const gsize *sizes)
+{
+  gsize total = 0;
+  int i;
+
+  for (i = 0; i < OSSO_ABOOK_HOME_MEMORY_LAST; i++)
+    total += sizes[i];
+
+  return total;
+}
+
+static gsize
+append_sizes(GString *report, const char *name, const gsize *sizes)
+{
+  gsize total = get_total(sizes);
+  int i;
+
+  g_string_append_printf(report, "  %s:", name);
+
+  for (i = 0; i < OSSO_ABOOK_HOME_MEMORY_LAST; i++)
+  {
+    if (sizes[i])
+    {
+      g_string_append_printf(report, " %s %" G_GSIZE_FORMAT,
+                             category_names[i], sizes[i]);
+    }
+  }
+
+  g_string_append_printf(report, " total %" G_GSIZE_FORMAT, total);
+
+  return total;
+}
+
+gchar *
+osso_abook_home_memory_report()
+{
+  GString *report = g_string_new("Memory usage in bytes:\n");
+  gsize totals[OSSO_ABOOK_HOME_MEMORY_LAST] = {0, };
+  guint applets = 0;
+  GList *l;
+  int i;
+
+  for (l = sources; l; l = l->next)
+  {
+    OssoABookHomeMemorySource *source = l->data;
+    gsize sizes[OSSO_ABOOK_HOME_MEMORY_LAST] = {0, };
+    gsize total;
+
+    source->func(sizes, source->user_data);
+    total = append_sizes(report, source->name, sizes);
+
+    if (source->applet)
+    {
+      applets++;
+
+      if (total > OSSO_ABOOK_HOME_MEMORY_APPLET_BUDGET)
+      {
+        g_warning("Applet %s uses %" G_GSIZE_FORMAT " bytes, budget is %d",
+                  source->name, total, OSSO_ABOOK_HOME_MEMORY_APPLET_BUDGET);
+        g_string_append(report, " OVER BUDGET");
+      }
+    }
+
+    g_string_append_c(report, '\n');
+
+    for (i = 0; i < OSSO_ABOOK_HOME_MEMORY_LAST; i++)
+      totals[i] += sizes[i];
+  }
+
+  append_sizes(report, "all", totals);
+  g_string_append_printf(report, " in %u applets\n", applets);
+
+  return g_string_free(report, FALSE);
+}
+
+guint
+osso_abook_home_memory_get_over_budget()
+{
+  guint over_budget = 0;
+  GList *l;
+
+  for (l = sources; l; l = l->next)
+  {
+    OssoABookHomeMemorySource *source = l->data;
+    gsize sizes[OSSO_ABOOK_HOME_MEMORY_LAST] = {0, };
+
+    if (!source->applet)
+      continue;
+
+    source->func(sizes, source->user_data);
+
+    if (get_total(sizes) > OSSO_ABOOK_HOME_MEMORY_APPLET_BUDGET)
+      over_budget++;
+  }
+
+  return over_budget;
+}
+
+gsize
+osso_abook_home_memory_pixbuf_size(GdkPixbuf *pixbuf)
+{
+  GTypeQuery query;
+
+  if (!pixbuf)
+    return 0;
+
+  g_type_query(G_OBJECT_TYPE(pixbuf), &query);
+
+  return gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf) +
+         query.instance_size;
+}
+
+gsize
+osso_abook_home_memory_surface_size(cairo_surface_t *surface)
+{
+  /* only image surfaces live in our address space, anything else is a
+   * pixmap owned by the X server */
+  if (!surface ||
+      (cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE))
+  {
+    return 0;
+  }
+
+  return cairo_image_surface_get_stride(surface) *
+         cairo_image_surface_get_height(surface);
+}
+
+void
+osso_abook_home_memory_add_surface(gsize *sizes,
+                                   OssoABookHomeMemoryCategory category,
+                                   cairo_surface_t *surface)
+{
+  int depth;
+
+  if (!surface)
+    return;
+
+  if (cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE)
+  {
+    sizes[category] += osso_abook_home_memory_surface_size(surface);
+    return;
+  }
+
+  if (cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_XLIB)
+    return;
+
+  /* what the server most likely allocates for the pixmap, not a query */
+  depth = cairo_xlib_surface_get_depth(surface);
+  sizes[OSSO_ABOOK_HOME_MEMORY_PIXMAPS] +=
+    (gsize)cairo_xlib_surface_get_width(surface) *
+    cairo_xlib_surface_get_height(surface) *
+    (depth > 16 ? 4 : (depth > 8 ? 2 : 1));
+}
+
+gsize
+osso_abook_home_memory_layout_size(PangoLayout *layout)
+{
+  GTypeQuery query;
+  const char *text;
+  gsize size;
+
+  if (!layout)
+    return 0;
+
+  g_type_query(G_OBJECT_TYPE(layout), &query);
+  size = query.instance_size;
+  text = pango_layout_get_text(layout);
+
+  /* an estimate: text copy and log attrs plus the lines pango keeps */
+  if (text)
+    size += strlen(text) * (1 + sizeof(PangoLogAttr));
+
+  size += pango_layout_get_line_count(layout) * sizeof(PangoLayoutLine);
+
+  return size;
+}
+
+gsize
+osso_abook_home_memory_widget_size(GtkWidget *widget)
+{
+  GTypeQuery query;
+  gsize size;
+
+  if (!widget)
+    return 0;
+
+  g_type_query(G_OBJECT_TYPE(widget), &query);
+  size = query.instance_size;
+
+  if (GTK_IS_CONTAINER(widget))
+  {
+    GList *children = gtk_container_get_children(GTK_CONTAINER(widget));
+    GList *l;
+
+    for (l = children; l; l = l->next)
+      size += osso_abook_home_memory_widget_size(l->data);
+
+    g_list_free(children);
+  }
+
+  return size;
+}
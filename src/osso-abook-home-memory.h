@@ -0,0 +1,90 @@
+/*
+ * osso-abook-home-memory.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_MEMORY_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_MEMORY_H_INCLUDED__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* per applet footprint above which the report complains, in bytes */
+#ifndef OSSO_ABOOK_HOME_MEMORY_APPLET_BUDGET
+#define OSSO_ABOOK_HOME_MEMORY_APPLET_BUDGET (256 * 1024)
+#endif
+
+typedef enum
+{
+  OSSO_ABOOK_HOME_MEMORY_AVATAR,
+  OSSO_ABOOK_HOME_MEMORY_PRESENCE,
+  OSSO_ABOOK_HOME_MEMORY_LABEL,
+  OSSO_ABOOK_HOME_MEMORY_WIDGETS,
+  OSSO_ABOOK_HOME_MEMORY_FRAMES,
+  OSSO_ABOOK_HOME_MEMORY_MASK,
+  OSSO_ABOOK_HOME_MEMORY_ROSTER,
+  OSSO_ABOOK_HOME_MEMORY_PIXMAPS,
+  OSSO_ABOOK_HOME_MEMORY_LAST
+} OssoABookHomeMemoryCategory;
+
+/* adds the bytes owned by user_data to sizes, indexed by category */
+typedef void (*OssoABookHomeMemoryFunc)(gsize *sizes, gpointer user_data);
+
+void
+osso_abook_home_memory_add_applet(const char *name,
+                                  OssoABookHomeMemoryFunc func,
+                                  gpointer user_data);
+
+void
+osso_abook_home_memory_add_shared(const char *name,
+                                  OssoABookHomeMemoryFunc func,
+                                  gpointer user_data);
+
+void
+osso_abook_home_memory_remove(OssoABookHomeMemoryFunc func,
+                              gpointer user_data);
+
+gchar *
+osso_abook_home_memory_report(void);
+
+/* number of applets whose footprint is above the budget */
+guint
+osso_abook_home_memory_get_over_budget(void);
+
+gsize
+osso_abook_home_memory_pixbuf_size(GdkPixbuf *pixbuf);
+
+gsize
+osso_abook_home_memory_surface_size(cairo_surface_t *surface);
+
+/* adds surface to category if it is an image surface, or its estimated size
+ * to OSSO_ABOOK_HOME_MEMORY_PIXMAPS if it lives in the X server */
+void
+osso_abook_home_memory_add_surface(gsize *sizes,
+                                   OssoABookHomeMemoryCategory category,
+                                   cairo_surface_t *surface);
+
+gsize
+osso_abook_home_memory_layout_size(PangoLayout *layout);
+
+gsize
+osso_abook_home_memory_widget_size(GtkWidget *widget);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_MEMORY_H_INCLUDED__ */
@@ -0,0 +1,217 @@
+/*
+ * osso-abook-home-name-renderer.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-name-renderer.h"
+#include "osso-abook-home-theme.h"
+
+struct _OssoABookHomeNameRenderer
+{
+  GString *text;
+  int max_width;
+  PangoLayout *layout;
+  cairo_surface_t *surface;
+  gboolean dirty;
+  GdkColor shadow_color;
+  double shadow_alpha;
+  int shadow_offset;
+};
+
+OssoABookHomeNameRenderer *
+osso_abook_home_name_renderer_new()
+{
+  return g_slice_new0(OssoABookHomeNameRenderer);
+}
+
+static void
+drop_surface(OssoABookHomeNameRenderer *renderer)
+{
+  if (renderer->surface)
+  {
+    cairo_surface_destroy(renderer->surface);
+    renderer->surface = NULL;
+  }
+}
+
+void
+osso_abook_home_name_renderer_invalidate(OssoABookHomeNameRenderer *renderer)
+{
+  drop_surface(renderer);
+
+  /* font, shadow and pango context come from the style, so the layout
+   * goes too */
+  if (renderer->layout)
+  {
+    g_object_unref(renderer->layout);
+    renderer->layout = NULL;
+  }
+}
+
+void
+osso_abook_home_name_renderer_free(OssoABookHomeNameRenderer *renderer)
+{
+  if (!renderer)
+    return;
+
+  osso_abook_home_name_renderer_invalidate(renderer);
+
+  if (renderer->text)
+    g_string_free(renderer->text, TRUE);
+
+  g_slice_free(OssoABookHomeNameRenderer, renderer);
+}
+
+gboolean
+osso_abook_home_name_renderer_set_text(OssoABookHomeNameRenderer *renderer,
+                                       const char *text)
+{
+  const char *current = renderer->text ? renderer->text->str : "";
+
+  if (!text)
+    text = "";
+
+  if (!strcmp(current, text))
+    return FALSE;
+
+  /* the text buffer and, if the size stays the same, the bitmap are reused,
+   * so a changing name doesn't allocate once they are big enough */
+  if (renderer->text)
+    g_string_assign(renderer->text, text);
+  else
+    renderer->text = g_string_new(text);
+
+  renderer->dirty = TRUE;
+
+  return TRUE;
+}
+
+static void
+ensure_surface(OssoABookHomeNameRenderer *renderer, GtkWidget *widget,
+               int max_width)
+{
+  GdkColor color;
+  cairo_t *cr;
+  int width;
+  int height;
+
+  if (renderer->surface && !renderer->dirty &&
+      (renderer->max_width == max_width))
+  {
+    return;
+  }
+
+  if (!renderer->layout)
+  {
+    renderer->layout = gtk_widget_create_pango_layout(widget, NULL);
+    pango_layout_set_font_description(
+      renderer->layout, osso_abook_home_theme_get_name_font(widget));
+    pango_layout_set_ellipsize(renderer->layout, PANGO_ELLIPSIZE_END);
+    osso_abook_home_theme_get_name_shadow(
+      widget, &renderer->shadow_color, &renderer->shadow_alpha,
+      &renderer->shadow_offset);
+  }
+
+  renderer->max_width = max_width;
+  pango_layout_set_text(renderer->layout,
+                        renderer->text ? renderer->text->str : "", -1);
+  pango_layout_set_width(renderer->layout,
+                         (max_width - renderer->shadow_offset) * PANGO_SCALE);
+  pango_layout_get_pixel_size(renderer->layout, &width, &height);
+
+  width += renderer->shadow_offset;
+  height += renderer->shadow_offset;
+
+  if (renderer->surface &&
+      ((cairo_image_surface_get_width(renderer->surface) != width) ||
+       (cairo_image_surface_get_height(renderer->surface) != height)))
+  {
+    drop_surface(renderer);
+  }
+
+  if (!renderer->surface)
+  {
+    renderer->surface =
+      cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+  }
+
+  renderer->dirty = FALSE;
+  cr = cairo_create(renderer->surface);
+  cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+  if (renderer->shadow_offset)
+  {
+    cairo_set_source_rgba(cr, renderer->shadow_color.red / 65535.0,
+                          renderer->shadow_color.green / 65535.0,
+                          renderer->shadow_color.blue / 65535.0,
+                          renderer->shadow_alpha);
+    cairo_move_to(cr, renderer->shadow_offset, renderer->shadow_offset);
+    pango_cairo_show_layout(cr, renderer->layout);
+  }
+
+  osso_abook_home_theme_get_name_color(widget, &color);
+  gdk_cairo_set_source_color(cr, &color);
+  cairo_move_to(cr, 0.0, 0.0);
+  pango_cairo_show_layout(cr, renderer->layout);
+
+  cairo_destroy(cr);
+}
+
+void
+osso_abook_home_name_renderer_get_size(OssoABookHomeNameRenderer *renderer,
+                                       GtkWidget *widget, int max_width,
+                                       int *width, int *height)
+{
+  ensure_surface(renderer, widget, max_width);
+
+  if (width)
+    *width = cairo_image_surface_get_width(renderer->surface);
+
+  if (height)
+    *height = cairo_image_surface_get_height(renderer->surface);
+}
+
+void
+osso_abook_home_name_renderer_draw(OssoABookHomeNameRenderer *renderer,
+                                   GtkWidget *widget, cairo_t *cr,
+                                   int max_width, double x, double y)
+{
+  ensure_surface(renderer, widget, max_width);
+
+  cairo_save(cr);
+  cairo_set_source_surface(cr, renderer->surface, x, y);
+  cairo_rectangle(cr, x, y,
+                  cairo_image_surface_get_width(renderer->surface),
+                  cairo_image_surface_get_height(renderer->surface));
+  cairo_fill(cr);
+  cairo_restore(cr);
+}
+
+gsize
+osso_abook_home_name_renderer_get_footprint(
+  OssoABookHomeNameRenderer *renderer)
+{
+  return osso_abook_home_memory_layout_size(renderer->layout) +
+         osso_abook_home_memory_surface_size(renderer->surface);
+}
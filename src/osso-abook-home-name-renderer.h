@@ -0,0 +1,62 @@
+/*
+ * osso-abook-home-name-renderer.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_NAME_RENDERER_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_NAME_RENDERER_H_INCLUDED__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* Renders a contact name the way a hildon-shadow-label with SmallSystemFont
+ * would, but keeps the layout and the shadowed bitmap around until either
+ * the text, the available width or the style changes.
+ */
+typedef struct _OssoABookHomeNameRenderer OssoABookHomeNameRenderer;
+
+OssoABookHomeNameRenderer *
+osso_abook_home_name_renderer_new(void);
+
+void
+osso_abook_home_name_renderer_free(OssoABookHomeNameRenderer *renderer);
+
+gboolean
+osso_abook_home_name_renderer_set_text(OssoABookHomeNameRenderer *renderer,
+                                       const char *text);
+
+void
+osso_abook_home_name_renderer_invalidate(OssoABookHomeNameRenderer *renderer);
+
+void
+osso_abook_home_name_renderer_get_size(OssoABookHomeNameRenderer *renderer,
+                                       GtkWidget *widget, int max_width,
+                                       int *width, int *height);
+
+void
+osso_abook_home_name_renderer_draw(OssoABookHomeNameRenderer *renderer,
+                                   GtkWidget *widget, cairo_t *cr,
+                                   int max_width, double x, double y);
+
+gsize
+osso_abook_home_name_renderer_get_footprint(
+  OssoABookHomeNameRenderer *renderer);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_NAME_RENDERER_H_INCLUDED__ */
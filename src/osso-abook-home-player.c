@@ -0,0 +1,462 @@
+/*
+ * osso-abook-home-player.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <libosso-abook/osso-abook-init.h>
+
+#include <string.h>
+
+#include "osso-abook-home-aggregator.h"
+#include "osso-abook-home-applet.h"
+#include "osso-abook-home-player.h"
+#include "osso-abook-home-theme.h"
+
+/* source size of the generated avatars, about what a camera photo gets
+ * cropped to by the address book */
+#define AVATAR_SIZE 256
+
+#define GRID_COLUMNS 5
+
+/* A contact that reports the recorded presence and avatar instead of
+ * aggregating them from roster contacts.
+ */
+struct _OssoABookHomePlayerContact
+{
+  OssoABookContact parent;
+  guint64 id;
+  guint presence_type;
+  guint avatar_serial;
+  GdkPixbuf *image;
+};
+
+typedef struct _OssoABookHomePlayerContact OssoABookHomePlayerContact;
+
+struct _OssoABookHomePlayerContactClass
+{
+  OssoABookContactClass parent_class;
+};
+
+typedef struct _OssoABookHomePlayerContactClass OssoABookHomePlayerContactClass;
+
+static void
+player_contact_presence_init(OssoABookPresenceIface *iface);
+
+static void
+player_contact_avatar_init(OssoABookAvatarIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(
+  OssoABookHomePlayerContact,
+  osso_abook_home_player_contact,
+  OSSO_ABOOK_TYPE_CONTACT,
+  G_IMPLEMENT_INTERFACE(OSSO_ABOOK_TYPE_PRESENCE,
+                        player_contact_presence_init);
+  G_IMPLEMENT_INTERFACE(OSSO_ABOOK_TYPE_AVATAR,
+                        player_contact_avatar_init);
+);
+
+#define PLAYER_CONTACT(contact) ((OssoABookHomePlayerContact *)(contact))
+
+static osso_context_t *osso = NULL;
+static OssoABookAggregator *aggregator = NULL;
+static GPtrArray *applets = NULL;
+
+/* stand-ins by trace id, the key is the id inside the contact */
+static GHashTable *contacts = NULL;
+
+static TpConnectionPresenceType
+player_contact_get_presence_type(OssoABookPresence *presence)
+{
+  return PLAYER_CONTACT(presence)->presence_type;
+}
+
+static const char *
+player_contact_get_presence_status(OssoABookPresence *presence)
+{
+  switch (PLAYER_CONTACT(presence)->presence_type)
+  {
+    case TP_CONNECTION_PRESENCE_TYPE_OFFLINE:
+      return "offline";
+    case TP_CONNECTION_PRESENCE_TYPE_AVAILABLE:
+      return "available";
+    case TP_CONNECTION_PRESENCE_TYPE_AWAY:
+      return "away";
+    case TP_CONNECTION_PRESENCE_TYPE_EXTENDED_AWAY:
+      return "xa";
+    case TP_CONNECTION_PRESENCE_TYPE_HIDDEN:
+      return "hidden";
+    case TP_CONNECTION_PRESENCE_TYPE_BUSY:
+      return "busy";
+    default:
+      return NULL;
+  }
+}
+
+static void
+player_contact_presence_init(OssoABookPresenceIface *iface)
+{
+  iface->get_presence_type = player_contact_get_presence_type;
+  iface->get_presence_status = player_contact_get_presence_status;
+}
+
+/* a flat colour per contact and serial, the scaling cost is the same as for
+ * a photo of that size */
+static GdkPixbuf *
+player_contact_get_image(OssoABookAvatar *avatar)
+{
+  OssoABookHomePlayerContact *contact = PLAYER_CONTACT(avatar);
+
+  if (!contact->image)
+  {
+    guint32 pixel = (contact->id ^ (contact->avatar_serial * 0x9e3779b9u));
+
+    contact->image = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8,
+                                    AVATAR_SIZE, AVATAR_SIZE);
+    gdk_pixbuf_fill(contact->image, (pixel << 8) | 0xff);
+  }
+
+  return g_object_ref(contact->image);
+}
+
+/* the token changes along with the image, like it does for real contacts */
+static gpointer
+player_contact_get_image_token(OssoABookAvatar *avatar)
+{
+  GdkPixbuf *image = player_contact_get_image(avatar);
+
+  g_object_unref(image);
+
+  return image;
+}
+
+static void
+player_contact_avatar_init(OssoABookAvatarIface *iface)
+{
+  iface->get_image = player_contact_get_image;
+  iface->get_image_token = player_contact_get_image_token;
+}
+
+static void
+osso_abook_home_player_contact_finalize(GObject *object)
+{
+  OssoABookHomePlayerContact *contact = PLAYER_CONTACT(object);
+
+  if (contact->image)
+    g_object_unref(contact->image);
+
+  G_OBJECT_CLASS(osso_abook_home_player_contact_parent_class)->finalize(
+    object);
+}
+
+static void
+osso_abook_home_player_contact_class_init(
+  OssoABookHomePlayerContactClass *klass)
+{
+  G_OBJECT_CLASS(klass)->finalize = osso_abook_home_player_contact_finalize;
+}
+
+static void
+osso_abook_home_player_contact_init(OssoABookHomePlayerContact *contact)
+{
+}
+
+/* a name of the recorded length, made of the hashed UID */
+static void
+set_name(OssoABookHomePlayerContact *contact, guint name_length)
+{
+  EContact *ec = E_CONTACT(contact);
+  const char *nickname = e_contact_get_const(ec, E_CONTACT_NICKNAME);
+  gchar id[17];
+  GString *name;
+
+  if ((nickname ? strlen(nickname) : 0) == name_length)
+    return;
+
+  g_snprintf(id, sizeof(id), "%016" G_GINT64_MODIFIER "x", contact->id);
+  name = g_string_sized_new(name_length);
+
+  while (name->len < name_length)
+    g_string_append_c(name, id[name->len % 16]);
+
+  e_contact_set(ec, E_CONTACT_NICKNAME, name->len ? name->str : NULL);
+  g_string_free(name, TRUE);
+}
+
+static void
+set_state(OssoABookHomePlayerContact *contact,
+          const OssoABookHomeTraceContact *trace_contact)
+{
+  set_name(contact, trace_contact->name_length);
+  contact->presence_type = trace_contact->presence_type;
+
+  if (contact->avatar_serial != trace_contact->avatar_serial)
+  {
+    GdkPixbuf *old_image = contact->image;
+
+    contact->avatar_serial = trace_contact->avatar_serial;
+
+    /* the new image is made while the old one is alive, so the token can't
+     * come back at the same address and look unchanged */
+    if (old_image)
+    {
+      contact->image = NULL;
+      g_object_unref(player_contact_get_image(OSSO_ABOOK_AVATAR(contact)));
+      g_object_unref(old_image);
+    }
+  }
+}
+
+static OssoABookContact *
+create_contact(const OssoABookHomeTraceContact *trace_contact)
+{
+  OssoABookHomePlayerContact *contact =
+    g_object_new(osso_abook_home_player_contact_get_type(), NULL);
+  gchar *uid = osso_abook_home_trace_format_id(trace_contact->id);
+
+  contact->id = trace_contact->id;
+  e_contact_set(E_CONTACT(contact), E_CONTACT_UID, uid);
+  set_state(contact, trace_contact);
+  g_free(uid);
+
+  return OSSO_ABOOK_CONTACT(contact);
+}
+
+int
+osso_abook_home_player_init(const char *name, int *argc, char ***argv,
+                            const char *parameter_string,
+                            GOptionEntry *entries)
+{
+  GError *error = NULL;
+  int rv = 0;
+
+  osso = osso_initialize(name, PACKAGE_VERSION, FALSE, NULL);
+
+  if (!osso)
+  {
+    g_critical("Error initializing osso\n");
+    return 1;
+  }
+
+  if (!osso_abook_init_with_args(argc, argv, osso, parameter_string, entries,
+                                 NULL, &error))
+  {
+    if (error && (G_OPTION_ERROR == error->domain))
+    {
+      g_printerr("Usage error: %s\n", error->message);
+      rv = 2;
+    }
+    else
+    {
+      g_critical("Unable to initialize libosso-abook");
+      rv = 1;
+    }
+
+    g_clear_error(&error);
+    osso_abook_home_player_deinit();
+  }
+
+  return rv;
+}
+
+void
+osso_abook_home_player_deinit()
+{
+  if (osso)
+  {
+    osso_deinitialize(osso);
+    osso = NULL;
+  }
+}
+
+void
+osso_abook_home_player_start()
+{
+  g_return_if_fail(applets == NULL);
+
+  applets = g_ptr_array_new();
+  contacts = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL,
+                                   g_object_unref);
+  aggregator = osso_abook_home_aggregator_start_replay();
+}
+
+void
+osso_abook_home_player_stop()
+{
+  guint i;
+
+  g_return_if_fail(applets != NULL);
+
+  for (i = 0; i < applets->len; i++)
+    gtk_widget_destroy(g_ptr_array_index(applets, i));
+
+  g_ptr_array_free(applets, TRUE);
+  applets = NULL;
+  g_hash_table_destroy(contacts);
+  contacts = NULL;
+}
+
+GPtrArray *
+osso_abook_home_player_get_applets()
+{
+  return applets;
+}
+
+OssoABookContact *
+osso_abook_home_player_set_state(const OssoABookHomeTraceContact *contact)
+{
+  OssoABookHomePlayerContact *stand_in =
+    g_hash_table_lookup(contacts, &contact->id);
+
+  if (stand_in)
+    set_state(stand_in, contact);
+
+  return OSSO_ABOOK_CONTACT(stand_in);
+}
+
+/* tiles side by side, so none of them is obscured and every expose runs */
+static void
+play_applet(const OssoABookHomeTraceEvent *event)
+{
+  gchar *uid = osso_abook_home_trace_format_id(event->contacts[0].id);
+  gchar *plugin_id = g_strconcat(OSSO_ABOOK_HOME_APPLET_PREFIX, uid, NULL);
+  GtkWidget *applet = g_object_new(OSSO_ABOOK_TYPE_HOME_APPLET,
+                                   "plugin-id", plugin_id,
+                                   NULL);
+
+  gtk_window_move(GTK_WINDOW(applet),
+                  (applets->len % GRID_COLUMNS) *
+                  OSSO_ABOOK_HOME_THEME_TILE_WIDTH,
+                  (applets->len / GRID_COLUMNS) *
+                  OSSO_ABOOK_HOME_THEME_TILE_HEIGHT);
+  g_ptr_array_add(applets, applet);
+
+  /* the applet only maps once its contact resolves */
+  gtk_widget_show(applet);
+  g_free(plugin_id);
+  g_free(uid);
+}
+
+static void
+play_contacts_added(const OssoABookHomeTraceEvent *event)
+{
+  OssoABookContact **added = g_new0(OssoABookContact *, event->n_contacts + 1);
+  guint i;
+
+  for (i = 0; i < event->n_contacts; i++)
+  {
+    added[i] = create_contact(&event->contacts[i]);
+    g_hash_table_replace(contacts, &PLAYER_CONTACT(added[i])->id,
+                         g_object_ref(added[i]));
+  }
+
+  g_signal_emit_by_name(aggregator, "contacts-added", added);
+
+  for (i = 0; i < event->n_contacts; i++)
+    g_object_unref(added[i]);
+
+  g_free(added);
+}
+
+static void
+play_contacts_removed(const OssoABookHomeTraceEvent *event)
+{
+  gchar **uids = g_new0(gchar *, event->n_contacts + 1);
+  guint i;
+
+  for (i = 0; i < event->n_contacts; i++)
+    uids[i] = osso_abook_home_trace_format_id(event->contacts[i].id);
+
+  g_signal_emit_by_name(aggregator, "contacts-removed", uids);
+
+  for (i = 0; i < event->n_contacts; i++)
+    g_hash_table_remove(contacts, &event->contacts[i].id);
+
+  g_strfreev(uids);
+}
+
+static void
+play_contact_event(const OssoABookHomeTraceEvent *event)
+{
+  OssoABookContact *contact =
+    osso_abook_home_player_set_state(&event->contacts[0]);
+
+  /* recorded on a contact the aggregator did not list, nothing to do */
+  if (!contact)
+    return;
+
+  switch (event->type)
+  {
+    case OSSO_ABOOK_HOME_TRACE_PRESENCE_TYPE:
+      g_object_notify(G_OBJECT(contact), "presence-type");
+      break;
+    case OSSO_ABOOK_HOME_TRACE_AVATAR_IMAGE:
+      g_object_notify(G_OBJECT(contact), "avatar-image");
+      break;
+    case OSSO_ABOOK_HOME_TRACE_RESET:
+      g_signal_emit_by_name(contact, "reset");
+      break;
+    default:
+      g_assert_not_reached();
+  }
+}
+
+void
+osso_abook_home_player_play(const OssoABookHomeTraceEvent *event)
+{
+  g_return_if_fail(applets != NULL);
+
+  if (!event->n_contacts &&
+      (event->type != OSSO_ABOOK_HOME_TRACE_CONTACTS_ADDED) &&
+      (event->type != OSSO_ABOOK_HOME_TRACE_CONTACTS_REMOVED))
+  {
+    g_warning("%s: event %d without a contact", __FUNCTION__, event->type);
+    return;
+  }
+
+  switch (event->type)
+  {
+    case OSSO_ABOOK_HOME_TRACE_APPLET:
+      play_applet(event);
+      break;
+    case OSSO_ABOOK_HOME_TRACE_CONTACTS_ADDED:
+      play_contacts_added(event);
+      break;
+    case OSSO_ABOOK_HOME_TRACE_CONTACTS_REMOVED:
+      play_contacts_removed(event);
+      break;
+    default:
+      play_contact_event(event);
+      break;
+  }
+
+  osso_abook_home_player_flush();
+}
+
+void
+osso_abook_home_player_flush()
+{
+  /* the server has seen our maps once this returns, so their exposes are
+   * queued by the time we look */
+  gdk_display_sync(gdk_display_get_default());
+
+  while (gtk_events_pending())
+    gtk_main_iteration_do(FALSE);
+
+  gdk_window_process_all_updates();
+}
@@ -0,0 +1,68 @@
+/*
+ * osso-abook-home-player.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_PLAYER_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_PLAYER_H_INCLUDED__
+
+#include <libosso-abook/osso-abook-contact.h>
+
+#include "osso-abook-home-trace.h"
+
+G_BEGIN_DECLS
+
+/* Plays trace events into real applets, without an address book. Applets
+ * are created for APPLET events and shown on a grid, contacts are stand-ins
+ * whose name length, presence and avatar follow the recorded state, so every
+ * replayed update does the work the recorded one did. Each event is played
+ * up to and including the exposes it causes.
+ */
+
+/* initializes libosso-abook, returns 0 or the exit code to fail with */
+int
+osso_abook_home_player_init(const char *name, int *argc, char ***argv,
+                            const char *parameter_string,
+                            GOptionEntry *entries);
+
+void
+osso_abook_home_player_deinit(void);
+
+void
+osso_abook_home_player_start(void);
+
+void
+osso_abook_home_player_stop(void);
+
+void
+osso_abook_home_player_play(const OssoABookHomeTraceEvent *event);
+
+/* brings the stand-in for trace_contact to its recorded state, returns it
+ * without emitting anything, NULL if it was never added */
+OssoABookContact *
+osso_abook_home_player_set_state(const OssoABookHomeTraceContact *contact);
+
+/* processes pending X events and paints everything invalidated */
+void
+osso_abook_home_player_flush(void);
+
+GPtrArray *
+osso_abook_home_player_get_applets(void);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_PLAYER_H_INCLUDED__ */
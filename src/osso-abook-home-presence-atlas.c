@@ -0,0 +1,172 @@
+/*
+ * osso-abook-home-presence-atlas.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <hildon/hildon.h>
+#include <libosso-abook/osso-abook-debug.h>
+
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-presence-atlas.h"
+
+#define ICON_SIZE OSSO_ABOOK_HOME_PRESENCE_ATLAS_ICON_SIZE
+
+/* Presence icons are few, so all of them are rendered once per theme into a
+ * single strip, one ICON_SIZE cell per icon name. Indices handed out by
+ * osso_abook_home_presence_atlas_lookup() stay valid across invalidation,
+ * only the pixels get re-rendered.
+ */
+static const char *known_icon_names[] =
+{
+  "general_presence_online",
+  "general_presence_away",
+  "general_presence_busy",
+  "general_presence_offline",
+  NULL
+};
+
+static GPtrArray *icon_names = NULL;
+static GHashTable *icon_indexes = NULL;
+static cairo_surface_t *atlas = NULL;
+static guint atlas_cells = 0;
+
+static gint
+add_icon_name(const char *icon_name)
+{
+  gchar *name = g_strdup(icon_name);
+
+  g_ptr_array_add(icon_names, name);
+  g_hash_table_insert(icon_indexes, name, GUINT_TO_POINTER(icon_names->len));
+
+  return icon_names->len - 1;
+}
+
+static void
+atlas_memory_usage_cb(gsize *sizes, gpointer user_data)
+{
+  sizes[OSSO_ABOOK_HOME_MEMORY_PRESENCE] +=
+    osso_abook_home_memory_surface_size(atlas);
+}
+
+static void
+ensure_icon_names()
+{
+  const char **name;
+
+  if (icon_names)
+    return;
+
+  icon_names = g_ptr_array_new();
+  icon_indexes = g_hash_table_new(g_str_hash, g_str_equal);
+
+  for (name = known_icon_names; *name; name++)
+    add_icon_name(*name);
+
+  osso_abook_home_memory_add_shared("presence atlas", atlas_memory_usage_cb,
+                                    NULL);
+}
+
+static void
+render_atlas()
+{
+  GtkIconTheme *icon_theme = gtk_icon_theme_get_default();
+  cairo_t *cr;
+  guint i;
+
+  if (atlas)
+    cairo_surface_destroy(atlas);
+
+  atlas = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                     icon_names->len * ICON_SIZE, ICON_SIZE);
+  atlas_cells = icon_names->len;
+  cr = cairo_create(atlas);
+
+  for (i = 0; i < icon_names->len; i++)
+  {
+    const char *icon_name = g_ptr_array_index(icon_names, i);
+    GdkPixbuf *pixbuf;
+    GError *error = NULL;
+
+    pixbuf = gtk_icon_theme_load_icon(icon_theme, icon_name, ICON_SIZE,
+                                      GTK_ICON_LOOKUP_USE_BUILTIN, &error);
+
+    if (!pixbuf)
+    {
+      OSSO_ABOOK_NOTE(GENERIC, "Unable to load presence icon %s: %s",
+                      icon_name, error ? error->message : "unknown error");
+      g_clear_error(&error);
+      continue;
+    }
+
+    gdk_cairo_set_source_pixbuf(
+      cr, pixbuf,
+      i * ICON_SIZE + (ICON_SIZE - gdk_pixbuf_get_width(pixbuf)) / 2,
+      (ICON_SIZE - gdk_pixbuf_get_height(pixbuf)) / 2);
+    cairo_rectangle(cr, i * ICON_SIZE, 0, ICON_SIZE, ICON_SIZE);
+    cairo_fill(cr);
+    g_object_unref(pixbuf);
+  }
+
+  cairo_destroy(cr);
+}
+
+gint
+osso_abook_home_presence_atlas_lookup(const char *icon_name)
+{
+  gpointer index;
+
+  if (!icon_name || !*icon_name)
+    return -1;
+
+  ensure_icon_names();
+
+  index = g_hash_table_lookup(icon_indexes, icon_name);
+
+  if (index)
+    return GPOINTER_TO_UINT(index) - 1;
+
+  return add_icon_name(icon_name);
+}
+
+void
+osso_abook_home_presence_atlas_draw(cairo_t *cr, gint index, double x,
+                                    double y)
+{
+  g_return_if_fail(icon_names != NULL);
+  g_return_if_fail(index >= 0 && (guint)index < icon_names->len);
+
+  if (!atlas || atlas_cells < icon_names->len)
+    render_atlas();
+
+  cairo_save(cr);
+  cairo_set_source_surface(cr, atlas, x - index * ICON_SIZE, y);
+  cairo_rectangle(cr, x, y, ICON_SIZE, ICON_SIZE);
+  cairo_fill(cr);
+  cairo_restore(cr);
+}
+
+void
+osso_abook_home_presence_atlas_invalidate()
+{
+  if (atlas)
+  {
+    cairo_surface_destroy(atlas);
+    atlas = NULL;
+  }
+}
@@ -0,0 +1,43 @@
+/*
+ * osso-abook-home-presence-atlas.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_PRESENCE_ATLAS_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_PRESENCE_ATLAS_H_INCLUDED__
+
+#include <cairo.h>
+#include <glib.h>
+#include <hildon/hildon-defines.h>
+
+G_BEGIN_DECLS
+
+#define OSSO_ABOOK_HOME_PRESENCE_ATLAS_ICON_SIZE HILDON_ICON_PIXEL_SIZE_XSMALL
+
+gint
+osso_abook_home_presence_atlas_lookup(const char *icon_name);
+
+void
+osso_abook_home_presence_atlas_draw(cairo_t *cr, gint index, double x,
+                                    double y);
+
+void
+osso_abook_home_presence_atlas_invalidate(void);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_PRESENCE_ATLAS_H_INCLUDED__ */
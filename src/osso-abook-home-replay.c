@@ -0,0 +1,198 @@
+/*
+ * osso-abook-home-replay.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-player.h"
+#include "osso-abook-home-stats.h"
+#include "osso-abook-home-wakeups.h"
+
+/* Feeds a trace recorded with OSSO_ABOOK_HOME_TRACE set through the applet
+ * callbacks, with the recorded timing or as fast as possible, and prints how
+ * long that took along with the usual reports. With --idle it then sits
+ * idle and exits with IDLE_WAKEUPS_EXIT_CODE if anything but its own timer
+ * woke the main loop up, or a source of ours fired periodically.
+ */
+
+#define IDLE_WAKEUPS_EXIT_CODE 3
+
+static gboolean fast = FALSE;
+static gint idle = 0;
+
+static GOptionEntry entries[] =
+{
+  {
+    "fast", 'f', 0, G_OPTION_ARG_NONE, &fast,
+    "Ignore the recorded timing and replay as fast as possible", NULL
+  },
+  {
+    "idle", 'i', 0, G_OPTION_ARG_INT, &idle,
+    "Stay idle for SECONDS after the replay and fail on any wakeup",
+    "SECONDS"
+  },
+  { NULL }
+};
+
+static FILE *trace = NULL;
+static OssoABookHomeTraceEvent next_event;
+static gint64 start_time = 0;
+static guint n_events = 0;
+static int exit_code = 0;
+static guint idle_start_wakeups = 0;
+
+static void
+print_report(gchar *report)
+{
+  g_print("%s", report);
+  g_free(report);
+}
+
+static gboolean
+idle_done_cb(gpointer user_data)
+{
+  guint periodic = osso_abook_home_wakeups_get_periodic();
+
+  /* the wakeup that dispatched this timer is the only one allowed */
+  guint wakeups = osso_abook_home_wakeups_get_main_loop() -
+    idle_start_wakeups - 1;
+
+  print_report(osso_abook_home_wakeups_report());
+
+  if (wakeups || periodic)
+  {
+    g_printerr("%u wakeups while idle, %u periodic\n", wakeups, periodic);
+    exit_code = IDLE_WAKEUPS_EXIT_CODE;
+  }
+
+  gtk_main_quit();
+
+  return FALSE;
+}
+
+/* runs once everything the replay queued has been dispatched */
+static gboolean
+idle_start_cb(gpointer user_data)
+{
+  g_print("Idling for %d s\n", idle);
+  osso_abook_home_wakeups_watch_main_loop();
+  idle_start_wakeups = osso_abook_home_wakeups_get_main_loop();
+  g_timeout_add_seconds(idle, idle_done_cb, NULL);
+
+  return FALSE;
+}
+
+static gboolean
+finish_cb(gpointer user_data)
+{
+  g_print("Replayed %u events in %.3f s\n", n_events,
+          (g_get_monotonic_time() - start_time) / (double)G_USEC_PER_SEC);
+  print_report(osso_abook_home_memory_report());
+  print_report(osso_abook_home_wakeups_report());
+  print_report(osso_abook_home_stats_report());
+
+  /* nothing changes from here on, anything that still wakes us up is a
+   * bug, whether it's a source of ours or gdk, GConf or D-Bus traffic */
+  if (idle > 0)
+  {
+    osso_abook_home_player_flush();
+    g_idle_add_full(G_PRIORITY_LOW, idle_start_cb, NULL, NULL);
+  }
+  else
+    gtk_main_quit();
+
+  return FALSE;
+}
+
+static gboolean
+replay_cb(gpointer user_data);
+
+static void
+schedule_next()
+{
+  /* from an idle, so an empty trace doesn't quit before gtk_main() */
+  if (!osso_abook_home_trace_read(trace, &next_event))
+  {
+    g_idle_add(finish_cb, NULL);
+    return;
+  }
+
+  if (fast)
+    g_idle_add(replay_cb, NULL);
+  else
+    g_timeout_add(next_event.delay / 1000, replay_cb, NULL);
+}
+
+static gboolean
+replay_cb(gpointer user_data)
+{
+  osso_abook_home_player_play(&next_event);
+  osso_abook_home_trace_event_clear(&next_event);
+  n_events++;
+  schedule_next();
+
+  return FALSE;
+}
+
+int
+main(int argc, char **argv)
+{
+  int rv;
+
+  rv = osso_abook_home_player_init("osso-abook-home-replay", &argc, &argv,
+                                   "TRACE", entries);
+
+  if (rv)
+    return rv;
+
+  if (argc != 2)
+  {
+    g_printerr("Usage: %s [--fast] [--idle SECONDS] TRACE\n", argv[0]);
+    osso_abook_home_player_deinit();
+
+    return 2;
+  }
+
+  trace = fopen(argv[1], "rb");
+
+  if (!trace || !osso_abook_home_trace_read_header(trace))
+  {
+    g_printerr("%s is not an applet trace\n", argv[1]);
+
+    if (trace)
+      fclose(trace);
+
+    osso_abook_home_player_deinit();
+
+    return 1;
+  }
+
+  osso_abook_home_player_start();
+  start_time = g_get_monotonic_time();
+  schedule_next();
+  gtk_main();
+
+  osso_abook_home_player_stop();
+  fclose(trace);
+  osso_abook_home_player_deinit();
+
+  return exit_code;
+}
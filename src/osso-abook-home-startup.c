@@ -0,0 +1,212 @@
+/*
+ * osso-abook-home-startup.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <gconf/gconf-client.h>
+
+#include "osso-abook-home-aggregator.h"
+#include "osso-abook-home-startup.h"
+#include "osso-abook-home-wakeups.h"
+
+#define HD_GCONF_APPLETS_DIR "/apps/osso/hildon-desktop/applets"
+#define HD_GCONF_VIEWS_DIR "/apps/osso/hildon-desktop/views"
+#define HD_GCONF_KEY_CURRENT_VIEW HD_GCONF_VIEWS_DIR "/current"
+
+struct _OssoABookHomeStartupItem
+{
+  HDHomePluginItem *item;
+  OssoABookHomeStartupFunc finish;
+  gint view;
+};
+
+typedef struct _OssoABookHomeStartupItem OssoABookHomeStartupItem;
+
+static GQueue pending = G_QUEUE_INIT;
+static GConfClient *gconf = NULL;
+static guint idle_id = 0;
+static gboolean aggregator_ready = FALSE;
+
+/* hildon-home keeps the view of every applet, 1 based, next to its
+ * position */
+static gint
+get_view(HDHomePluginItem *item)
+{
+  gchar *plugin_id;
+  gchar *key;
+  gint view;
+
+  g_object_get(item, "plugin-id", &plugin_id, NULL);
+  key = g_strdup_printf(HD_GCONF_APPLETS_DIR "/%s/view", plugin_id);
+  view = gconf_client_get_int(gconf, key, NULL);
+  g_free(key);
+  g_free(plugin_id);
+
+  return view;
+}
+
+static OssoABookHomeStartupItem *
+take_item(GList *l)
+{
+  OssoABookHomeStartupItem *pending_item = l->data;
+
+  g_queue_delete_link(&pending, l);
+
+  return pending_item;
+}
+
+static void
+finish_item(OssoABookHomeStartupItem *pending_item)
+{
+  pending_item->finish(pending_item->item);
+  g_slice_free(OssoABookHomeStartupItem, pending_item);
+}
+
+static void
+schedule_next();
+
+static gboolean
+finish_next_cb(gpointer user_data)
+{
+  idle_id = 0;
+
+  if (!g_queue_is_empty(&pending))
+    finish_item(take_item(g_queue_peek_head_link(&pending)));
+
+  /* one item per dispatch, so input and the visible applets go first */
+  schedule_next();
+
+  return FALSE;
+}
+
+static void
+schedule_next()
+{
+  if (!idle_id && aggregator_ready && !g_queue_is_empty(&pending))
+  {
+    idle_id = osso_abook_home_wakeups_idle_add_full(
+        OSSO_ABOOK_HOME_WAKEUP_STARTUP, G_PRIORITY_LOW, finish_next_cb, NULL);
+  }
+}
+
+static GList *
+find_item(HDHomePluginItem *item)
+{
+  GList *l;
+
+  for (l = g_queue_peek_head_link(&pending); l; l = l->next)
+  {
+    if (((OssoABookHomeStartupItem *)l->data)->item == item)
+      return l;
+  }
+
+  return NULL;
+}
+
+/* placeholders are never mapped, hildon-desktop can't tell them they became
+ * visible, so follow the view switches ourselves */
+static void
+current_view_notify_cb(GConfClient *client, guint cnxn_id, GConfEntry *entry,
+                       gpointer user_data)
+{
+  GList *l = g_queue_peek_head_link(&pending);
+  gint current;
+
+  if (!entry->value || (entry->value->type != GCONF_VALUE_INT))
+    return;
+
+  current = gconf_value_get_int(entry->value);
+
+  while (l)
+  {
+    GList *next = l->next;
+
+    if (((OssoABookHomeStartupItem *)l->data)->view == current)
+      finish_item(take_item(l));
+
+    l = next;
+  }
+}
+
+/* no point in finishing placeholders before there is something to resolve
+ * them against */
+static void
+aggregator_attach_cb(OssoABookAggregator *aggregator, gpointer user_data)
+{
+  aggregator_ready = TRUE;
+  schedule_next();
+}
+
+static void
+aggregator_detach_cb(OssoABookAggregator *aggregator, gpointer user_data)
+{
+  aggregator_ready = FALSE;
+}
+
+void
+osso_abook_home_startup_add(HDHomePluginItem *item,
+                            OssoABookHomeStartupFunc finish)
+{
+  OssoABookHomeStartupItem *pending_item;
+  gint current;
+  gint view;
+
+  if (!gconf)
+  {
+    gconf = gconf_client_get_default();
+    gconf_client_add_dir(gconf, HD_GCONF_VIEWS_DIR,
+                         GCONF_CLIENT_PRELOAD_NONE, NULL);
+    gconf_client_notify_add(gconf, HD_GCONF_KEY_CURRENT_VIEW,
+                            current_view_notify_cb, NULL, NULL, NULL);
+    osso_abook_home_aggregator_add_client(aggregator_attach_cb,
+                                          aggregator_detach_cb, &pending);
+  }
+
+  view = get_view(item);
+  current = gconf_client_get_int(gconf, HD_GCONF_KEY_CURRENT_VIEW, NULL);
+
+  /* anything we can't tell is treated as visible, so it is never delayed */
+  if (!view || !current || (view == current))
+  {
+    finish(item);
+    return;
+  }
+
+  pending_item = g_slice_new(OssoABookHomeStartupItem);
+  pending_item->item = item;
+  pending_item->finish = finish;
+  pending_item->view = view;
+  g_queue_push_tail(&pending, pending_item);
+  schedule_next();
+}
+
+void
+osso_abook_home_startup_remove(HDHomePluginItem *item)
+{
+  GList *l = find_item(item);
+
+  if (l)
+    g_slice_free(OssoABookHomeStartupItem, take_item(l));
+
+  if (g_queue_is_empty(&pending) && idle_id)
+  {
+    g_source_remove(idle_id);
+    idle_id = 0;
+  }
+}
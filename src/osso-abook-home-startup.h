@@ -0,0 +1,45 @@
+/*
+ * osso-abook-home-startup.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_STARTUP_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_STARTUP_H_INCLUDED__
+
+#include <libhildondesktop/hd-home-plugin-item.h>
+
+G_BEGIN_DECLS
+
+typedef void (*OssoABookHomeStartupFunc)(HDHomePluginItem *item);
+
+/* Runs finish for item right away if it is on the current home view.
+ * Items on other views stay placeholders and are finished one at a time
+ * from a low priority idle once the aggregator is ready, or as soon as the
+ * user switches to their view, whatever comes first. finish is expected to
+ * build the widgets, load the theme and resolve the contacts; subscriptions
+ * are made before, so the aggregator loads everything in one pass.
+ */
+void
+osso_abook_home_startup_add(HDHomePluginItem *item,
+                            OssoABookHomeStartupFunc finish);
+
+void
+osso_abook_home_startup_remove(HDHomePluginItem *item);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_STARTUP_H_INCLUDED__ */
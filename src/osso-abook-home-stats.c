@@ -0,0 +1,117 @@
+/*
+ * osso-abook-home-stats.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "osso-abook-home-stats.h"
+
+struct _OssoABookHomeLatencyStats
+{
+  guint count;
+  gint64 min;
+  gint64 max;
+  gint64 total;
+};
+
+typedef struct _OssoABookHomeLatencyStats OssoABookHomeLatencyStats;
+
+static const char *latency_names[OSSO_ABOOK_HOME_LATENCY_LAST] =
+{
+  "press",
+  "group-press"
+};
+
+static OssoABookHomeLatencyStats latencies[OSSO_ABOOK_HOME_LATENCY_LAST];
+
+static const char *counter_names[OSSO_ABOOK_HOME_COUNTER_LAST] =
+{
+  "resets",
+  "resets without visible change",
+  "theme surfaces converted"
+};
+
+static guint counters[OSSO_ABOOK_HOME_COUNTER_LAST];
+
+void
+osso_abook_home_stats_count(OssoABookHomeCounter counter)
+{
+  g_return_if_fail(counter < OSSO_ABOOK_HOME_COUNTER_LAST);
+
+  counters[counter]++;
+}
+
+guint
+osso_abook_home_stats_get_count(OssoABookHomeCounter counter)
+{
+  g_return_val_if_fail(counter < OSSO_ABOOK_HOME_COUNTER_LAST, 0);
+
+  return counters[counter];
+}
+
+void
+osso_abook_home_stats_add_latency(OssoABookHomeLatency latency, gint64 sample)
+{
+  OssoABookHomeLatencyStats *stats;
+
+  g_return_if_fail(latency < OSSO_ABOOK_HOME_LATENCY_LAST);
+
+  stats = &latencies[latency];
+
+  if (!stats->count || (sample < stats->min))
+    stats->min = sample;
+
+  if (!stats->count || (sample > stats->max))
+    stats->max = sample;
+
+  stats->total += sample;
+  stats->count++;
+}
+
+gchar *
+osso_abook_home_stats_report()
+{
+  GString *report = g_string_new("Counters:\n");
+  int i;
+
+  for (i = 0; i < OSSO_ABOOK_HOME_COUNTER_LAST; i++)
+  {
+    g_string_append_printf(report, "  %s: %u\n", counter_names[i],
+                           counters[i]);
+  }
+
+  g_string_append(report, "Latency:\n");
+
+  for (i = 0; i < OSSO_ABOOK_HOME_LATENCY_LAST; i++)
+  {
+    OssoABookHomeLatencyStats *stats = &latencies[i];
+
+    if (!stats->count)
+    {
+      g_string_append_printf(report, "  %s: no samples\n", latency_names[i]);
+      continue;
+    }
+
+    g_string_append_printf(
+      report, "  %s: %u samples, min %.1f ms, avg %.1f ms, max %.1f ms\n",
+      latency_names[i], stats->count, stats->min / 1000.0,
+      stats->total / (stats->count * 1000.0), stats->max / 1000.0);
+  }
+
+  return g_string_free(report, FALSE);
+}
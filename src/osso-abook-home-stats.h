@@ -0,0 +1,57 @@
+/*
+ * osso-abook-home-stats.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_STATS_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_STATS_H_INCLUDED__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  OSSO_ABOOK_HOME_LATENCY_PRESS,
+  OSSO_ABOOK_HOME_LATENCY_GROUP_PRESS,
+  OSSO_ABOOK_HOME_LATENCY_LAST
+} OssoABookHomeLatency;
+
+typedef enum
+{
+  OSSO_ABOOK_HOME_COUNTER_RESET,
+  OSSO_ABOOK_HOME_COUNTER_RESET_SKIPPED,
+  OSSO_ABOOK_HOME_COUNTER_THEME_CONVERSION,
+  OSSO_ABOOK_HOME_COUNTER_LAST
+} OssoABookHomeCounter;
+
+void
+osso_abook_home_stats_count(OssoABookHomeCounter counter);
+
+guint
+osso_abook_home_stats_get_count(OssoABookHomeCounter counter);
+
+/* sample is in microseconds, from g_get_monotonic_time() */
+void
+osso_abook_home_stats_add_latency(OssoABookHomeLatency latency, gint64 sample);
+
+gchar *
+osso_abook_home_stats_report(void);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_STATS_H_INCLUDED__ */
@@ -0,0 +1,471 @@
+/*
+ * osso-abook-home-theme.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "osso-abook-home-memory.h"
+#include "osso-abook-home-presence-atlas.h"
+#include "osso-abook-home-stats.h"
+#include "osso-abook-home-theme.h"
+
+static cairo_surface_t *frame_active = NULL;
+static cairo_surface_t *frame = NULL;
+static GdkRectangle frame_damage;
+static cairo_surface_t *avatar_mask = NULL;
+
+/* the rc style each applet type had when the assets were loaded, referenced
+ * so a new style can't show up at the address of a finalized one */
+static GHashTable *styles = NULL;
+
+/* the theme images converted for one screen and visual, so applets with RGBA
+ * and RGB colormaps each paint from a surface in their own format */
+typedef struct
+{
+  GdkScreen *screen;
+  GdkVisual *visual;
+  cairo_surface_t *frame;
+  cairo_surface_t *frame_active;
+  cairo_surface_t *avatar_mask;
+} OssoABookHomeThemeTarget;
+
+static GSList *targets = NULL;
+
+static void
+target_free(OssoABookHomeThemeTarget *target)
+{
+  if (target->frame)
+    cairo_surface_destroy(target->frame);
+
+  if (target->frame_active)
+    cairo_surface_destroy(target->frame_active);
+
+  if (target->avatar_mask)
+    cairo_surface_destroy(target->avatar_mask);
+
+  g_slice_free(OssoABookHomeThemeTarget, target);
+}
+
+static OssoABookHomeThemeTarget *
+get_target(GdkWindow *window)
+{
+  GdkScreen *screen = gdk_drawable_get_screen(window);
+  GdkVisual *visual = gdk_drawable_get_visual(window);
+  OssoABookHomeThemeTarget *target;
+  GSList *l;
+
+  for (l = targets; l; l = l->next)
+  {
+    target = l->data;
+
+    if ((target->screen == screen) && (target->visual == visual))
+      return target;
+  }
+
+  target = g_slice_new0(OssoABookHomeThemeTarget);
+  target->screen = screen;
+  target->visual = visual;
+  targets = g_slist_prepend(targets, target);
+
+  return target;
+}
+
+static void
+drop_targets()
+{
+  g_slist_free_full(targets, (GDestroyNotify)target_free);
+  targets = NULL;
+}
+
+static void
+theme_memory_usage_cb(gsize *sizes, gpointer user_data)
+{
+  GSList *l;
+
+  sizes[OSSO_ABOOK_HOME_MEMORY_FRAMES] +=
+    osso_abook_home_memory_surface_size(frame) +
+    osso_abook_home_memory_surface_size(frame_active);
+  sizes[OSSO_ABOOK_HOME_MEMORY_MASK] +=
+    osso_abook_home_memory_surface_size(avatar_mask);
+
+  for (l = targets; l; l = l->next)
+  {
+    OssoABookHomeThemeTarget *target = l->data;
+
+    osso_abook_home_memory_add_surface(sizes, OSSO_ABOOK_HOME_MEMORY_FRAMES,
+                                       target->frame);
+    osso_abook_home_memory_add_surface(sizes, OSSO_ABOOK_HOME_MEMORY_FRAMES,
+                                       target->frame_active);
+    osso_abook_home_memory_add_surface(sizes, OSSO_ABOOK_HOME_MEMORY_MASK,
+                                       target->avatar_mask);
+  }
+}
+
+static GdkPixbuf *
+load_pixbuf(GtkSettings *settings, gchar *pixmap_file)
+{
+  gchar *filename = gtk_rc_find_pixmap_in_path(settings, NULL, pixmap_file);
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+
+  g_return_val_if_fail(NULL != filename, NULL);
+
+  pixbuf = gdk_pixbuf_new_from_file(filename, &error);
+
+  if (error)
+  {
+    g_warning("%s: %s", __FUNCTION__, error->message);
+    g_clear_error(&error);
+  }
+
+  g_free(filename);
+
+  return pixbuf;
+}
+
+/* frames are painted on every expose, keep them in cairo's native format
+ * instead of converting from a pixbuf each time */
+static cairo_surface_t *
+load_frame(GtkSettings *settings, gchar *pixmap_file)
+{
+  GdkPixbuf *pixbuf = load_pixbuf(settings, pixmap_file);
+  cairo_surface_t *surface;
+  cairo_t *cr;
+
+  g_return_val_if_fail(NULL != pixbuf, NULL);
+
+  surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                       gdk_pixbuf_get_width(pixbuf),
+                                       gdk_pixbuf_get_height(pixbuf));
+  cr = cairo_create(surface);
+  gdk_cairo_set_source_pixbuf(cr, pixbuf, 0.0, 0.0);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+  g_object_unref(pixbuf);
+
+  return surface;
+}
+
+/* bounding box of the pixels that differ between the normal and the active
+ * frame, the only area that needs a redraw when the press state flips */
+static void
+update_frame_damage()
+{
+  int width = cairo_image_surface_get_width(frame);
+  int height = cairo_image_surface_get_height(frame);
+  int stride = cairo_image_surface_get_stride(frame);
+  int active_stride = cairo_image_surface_get_stride(frame_active);
+  const guchar *data;
+  const guchar *active_data;
+  int left = width;
+  int top = height;
+  int right = -1;
+  int bottom = -1;
+  int x;
+  int y;
+
+  frame_damage.x = 0;
+  frame_damage.y = 0;
+
+  if ((width != cairo_image_surface_get_width(frame_active)) ||
+      (height != cairo_image_surface_get_height(frame_active)))
+  {
+    frame_damage.width = MAX(width,
+                             cairo_image_surface_get_width(frame_active));
+    frame_damage.height = MAX(height,
+                              cairo_image_surface_get_height(frame_active));
+    return;
+  }
+
+  cairo_surface_flush(frame);
+  cairo_surface_flush(frame_active);
+  data = cairo_image_surface_get_data(frame);
+  active_data = cairo_image_surface_get_data(frame_active);
+
+  for (y = 0; y < height; y++)
+  {
+    const guint32 *row = (const guint32 *)(data + y * stride);
+    const guint32 *active_row =
+      (const guint32 *)(active_data + y * active_stride);
+
+    for (x = 0; x < width; x++)
+    {
+      if (row[x] != active_row[x])
+      {
+        left = MIN(left, x);
+        right = MAX(right, x);
+        top = MIN(top, y);
+        bottom = y;
+      }
+    }
+  }
+
+  if (right < 0)
+  {
+    frame_damage.width = 0;
+    frame_damage.height = 0;
+  }
+  else
+  {
+    frame_damage.x = left;
+    frame_damage.y = top;
+    frame_damage.width = right - left + 1;
+    frame_damage.height = bottom - top + 1;
+  }
+}
+
+/* theme assets are shared by all applets of the process, whatever their
+ * type. A theme switch or an rc reparse gives every widget type a new
+ * GtkStyle, so they are reloaded when a type that was already seen comes
+ * with a style it did not have at load time, and only once per reparse. */
+gboolean
+osso_abook_home_theme_update(GtkWidget *widget)
+{
+  GtkSettings *settings = gtk_widget_get_settings(widget);
+  GtkStyle *style = gtk_widget_get_style(widget);
+  gpointer type = GSIZE_TO_POINTER(G_OBJECT_TYPE(widget));
+  gchar *filename;
+
+  if (!styles)
+  {
+    styles = g_hash_table_new_full(NULL, NULL, NULL,
+                                   (GDestroyNotify)g_object_unref);
+  }
+
+  if (frame)
+  {
+    GtkStyle *known;
+
+    /* not anchored yet, it still has the default style */
+    if (!GTK_WIDGET_RC_STYLE(widget))
+      return FALSE;
+
+    known = g_hash_table_lookup(styles, type);
+
+    if (known == style)
+      return FALSE;
+
+    /* another applet type showing up, not a style change */
+    if (!known)
+    {
+      g_hash_table_insert(styles, type, g_object_ref(style));
+      return FALSE;
+    }
+  }
+  else
+    osso_abook_home_memory_add_shared("theme", theme_memory_usage_cb, NULL);
+
+  g_hash_table_remove_all(styles);
+
+  if (GTK_WIDGET_RC_STYLE(widget))
+    g_hash_table_insert(styles, type, g_object_ref(style));
+
+  drop_targets();
+
+  if (frame)
+    cairo_surface_destroy(frame);
+
+  frame = load_frame(settings, "ContactsAppletFrame.png");
+
+  g_assert(frame != NULL);
+
+  if (frame_active)
+    cairo_surface_destroy(frame_active);
+
+  frame_active = load_frame(settings, "ContactsAppletFrameActive.png");
+
+  g_assert(frame_active != NULL);
+
+  update_frame_damage();
+
+  if (avatar_mask)
+    cairo_surface_destroy(avatar_mask);
+
+  filename = gtk_rc_find_pixmap_in_path(settings, NULL,
+                                        "ContactsAppletMask.png");
+  avatar_mask = cairo_image_surface_create_from_png(filename);
+
+  g_assert(avatar_mask != NULL);
+
+  g_free(filename);
+
+  osso_abook_home_presence_atlas_invalidate();
+
+  return TRUE;
+}
+
+cairo_surface_t *
+osso_abook_home_theme_create_similar(GdkWindow *window,
+                                     cairo_surface_t *image,
+                                     cairo_content_t content)
+{
+  cairo_t *cr = gdk_cairo_create(window);
+  cairo_surface_t *surface;
+
+  surface = cairo_surface_create_similar(
+      cairo_get_target(cr), content,
+      cairo_image_surface_get_width(image),
+      cairo_image_surface_get_height(image));
+  cairo_destroy(cr);
+
+  cr = cairo_create(surface);
+  cairo_set_source_surface(cr, image, 0.0, 0.0);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+
+  return surface;
+}
+
+cairo_surface_t *
+osso_abook_home_theme_get_frame(GdkWindow *window, gboolean active)
+{
+  OssoABookHomeThemeTarget *target;
+  cairo_surface_t **surface;
+
+  if (!frame)
+    return NULL;
+
+  target = get_target(window);
+  surface = active ? &target->frame_active : &target->frame;
+
+  if (!*surface)
+  {
+    *surface = osso_abook_home_theme_create_similar(
+        window, active ? frame_active : frame, CAIRO_CONTENT_COLOR_ALPHA);
+    osso_abook_home_stats_count(OSSO_ABOOK_HOME_COUNTER_THEME_CONVERSION);
+  }
+
+  return *surface;
+}
+
+void
+osso_abook_home_theme_get_frame_damage(GdkRectangle *area)
+{
+  *area = frame_damage;
+}
+
+cairo_surface_t *
+osso_abook_home_theme_get_avatar_mask(GdkWindow *window)
+{
+  OssoABookHomeThemeTarget *target;
+
+  if (!avatar_mask)
+    return NULL;
+
+  target = get_target(window);
+
+  if (!target->avatar_mask)
+  {
+    target->avatar_mask = osso_abook_home_theme_create_similar(
+        window, avatar_mask, CAIRO_CONTENT_ALPHA);
+    osso_abook_home_stats_count(OSSO_ABOOK_HOME_COUNTER_THEME_CONVERSION);
+  }
+
+  return target->avatar_mask;
+}
+
+static GtkStyle *
+get_font_style(GtkWidget *widget)
+{
+  GtkStyle *font_style = gtk_rc_get_style_by_paths(
+      gtk_widget_get_settings(widget), "SmallSystemFont", NULL, G_TYPE_NONE);
+
+  return font_style ? font_style : gtk_widget_get_style(widget);
+}
+
+/* the same logical font and colour a hildon-shadow-label with
+ * SmallSystemFont would get */
+const PangoFontDescription *
+osso_abook_home_theme_get_name_font(GtkWidget *widget)
+{
+  GtkStyle *font_style = get_font_style(widget);
+
+  if (font_style->font_desc)
+    return font_style->font_desc;
+
+  return gtk_widget_get_style(widget)->font_desc;
+}
+
+void
+osso_abook_home_theme_install_style_properties(GtkWidgetClass *klass)
+{
+  gtk_widget_class_install_style_property(
+    klass,
+    g_param_spec_boxed("name-shadow-color", "Name shadow color",
+                       "Color of the shadow under the contact name",
+                       GDK_TYPE_COLOR, G_PARAM_READABLE));
+  gtk_widget_class_install_style_property(
+    klass,
+    g_param_spec_double("name-shadow-alpha", "Name shadow alpha",
+                        "Opacity of the shadow under the contact name",
+                        0.0, 1.0, 0.5, G_PARAM_READABLE));
+  gtk_widget_class_install_style_property(
+    klass,
+    g_param_spec_int("name-shadow-offset", "Name shadow offset",
+                     "Offset of the shadow under the contact name, in pixels",
+                     0, 8, 1, G_PARAM_READABLE));
+}
+
+/* read from the style the font comes from, so a theme that changes one
+ * can change the other along with it */
+void
+osso_abook_home_theme_get_name_shadow(GtkWidget *widget, GdkColor *color,
+                                      double *alpha, int *offset)
+{
+  GdkColor *shadow_color = NULL;
+
+  /* widgets that don't draw names in an applet get the defaults */
+  if (!gtk_widget_class_find_style_property(GTK_WIDGET_GET_CLASS(widget),
+                                            "name-shadow-color"))
+  {
+    gdk_color_parse("black", color);
+    *alpha = 0.5;
+    *offset = 1;
+
+    return;
+  }
+
+  gtk_style_get(get_font_style(widget), G_OBJECT_TYPE(widget),
+                "name-shadow-color", &shadow_color,
+                "name-shadow-alpha", alpha,
+                "name-shadow-offset", offset,
+                NULL);
+
+  if (shadow_color)
+  {
+    *color = *shadow_color;
+    gdk_color_free(shadow_color);
+  }
+  else
+    gdk_color_parse("black", color);
+}
+
+void
+osso_abook_home_theme_get_name_color(GtkWidget *widget, GdkColor *color)
+{
+  GtkStyle *label_style = gtk_rc_get_style_by_paths(
+      gtk_widget_get_settings(widget),
+      "osso-abook-home-applet.hildon-shadow-label", NULL, GTK_TYPE_LABEL);
+
+  if (!label_style)
+    label_style = gtk_widget_get_style(widget);
+
+  *color = label_style->fg[GTK_STATE_NORMAL];
+}
@@ -0,0 +1,75 @@
+/*
+ * osso-abook-home-theme.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_THEME_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_THEME_H_INCLUDED__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* geometry of a single contact tile, matches ContactsAppletFrame.png */
+#define OSSO_ABOOK_HOME_THEME_TILE_WIDTH 144
+#define OSSO_ABOOK_HOME_THEME_TILE_HEIGHT 178
+#define OSSO_ABOOK_HOME_THEME_AVATAR_X 8
+#define OSSO_ABOOK_HOME_THEME_AVATAR_Y 8
+#define OSSO_ABOOK_HOME_THEME_LABEL_X 12
+#define OSSO_ABOOK_HOME_THEME_LABEL_Y 140
+#define OSSO_ABOOK_HOME_THEME_LABEL_WIDTH 120
+#define OSSO_ABOOK_HOME_THEME_LABEL_HEIGHT 30
+
+gboolean
+osso_abook_home_theme_update(GtkWidget *widget);
+
+/* copy of image in the native format of window, with the given content */
+cairo_surface_t *
+osso_abook_home_theme_create_similar(GdkWindow *window,
+                                     cairo_surface_t *image,
+                                     cairo_content_t content);
+
+/* the theme surfaces below are converted once per screen and visual, and
+ * stay owned by the theme */
+cairo_surface_t *
+osso_abook_home_theme_get_frame(GdkWindow *window, gboolean active);
+
+/* area, in frame coordinates, where the active frame differs from the
+ * normal one */
+void
+osso_abook_home_theme_get_frame_damage(GdkRectangle *area);
+
+cairo_surface_t *
+osso_abook_home_theme_get_avatar_mask(GdkWindow *window);
+
+const PangoFontDescription *
+osso_abook_home_theme_get_name_font(GtkWidget *widget);
+
+void
+osso_abook_home_theme_get_name_color(GtkWidget *widget, GdkColor *color);
+
+/* adds the name-shadow-* style properties, for classes that draw names */
+void
+osso_abook_home_theme_install_style_properties(GtkWidgetClass *klass);
+
+void
+osso_abook_home_theme_get_name_shadow(GtkWidget *widget, GdkColor *color,
+                                      double *alpha, int *offset);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_THEME_H_INCLUDED__ */
@@ -0,0 +1,417 @@
+/*
+ * osso-abook-home-thumbnail-store.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include "osso-abook-home-thumbnail-store.h"
+
+#define THUMBNAIL_MAGIC 0x5448414f /* "OAHT" */
+#define THUMBNAIL_VERSION 1
+#define THUMBNAIL_SUFFIX ".argb"
+
+/* 32 bytes, so the pixels that follow stay 16 byte aligned in the mapping.
+ * Everything is in host byte order, same as cairo's ARGB32 pixels. */
+struct _OssoABookHomeThumbnailHeader
+{
+  guint32 magic;
+  guint32 version;
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  guint32 reserved[3];
+};
+
+typedef struct _OssoABookHomeThumbnailHeader OssoABookHomeThumbnailHeader;
+
+/* what the store knows about a thumbnail on disk, used is a sequence number
+ * bumped on every lookup and save, the least recently used is evicted first */
+struct _OssoABookHomeThumbnailEntry
+{
+  goffset size;
+  guint64 used;
+};
+
+typedef struct _OssoABookHomeThumbnailEntry OssoABookHomeThumbnailEntry;
+
+static const cairo_user_data_key_t mapped_file_key;
+
+/* thumbnail file name -> OssoABookHomeThumbnailEntry, NULL until first use */
+static GHashTable *entries = NULL;
+static goffset total_size = 0;
+static guint64 use_count = 0;
+
+static gchar *
+get_store_dir()
+{
+  return g_build_filename(g_get_user_cache_dir(), "osso-abook-home-applet",
+                          NULL);
+}
+
+static gchar *
+get_thumbnail_name(const char *key, int size)
+{
+  return g_strdup_printf("%s-%d" THUMBNAIL_SUFFIX, key, size);
+}
+
+const char *
+osso_abook_home_thumbnail_store_get_key(const char *source)
+{
+  static GChecksum *checksum = NULL;
+
+  g_return_val_if_fail(source != NULL, NULL);
+
+  if (checksum)
+    g_checksum_reset(checksum);
+  else
+    checksum = g_checksum_new(G_CHECKSUM_SHA1);
+
+  g_checksum_update(checksum, (const guchar *)source, -1);
+
+  return g_checksum_get_string(checksum);
+}
+
+struct _OssoABookHomeThumbnailFile
+{
+  gchar *name;
+  time_t mtime;
+  goffset size;
+};
+
+typedef struct _OssoABookHomeThumbnailFile OssoABookHomeThumbnailFile;
+
+static gint
+compare_files(gconstpointer a, gconstpointer b)
+{
+  const OssoABookHomeThumbnailFile *file_a = a;
+  const OssoABookHomeThumbnailFile *file_b = b;
+
+  if (file_a->mtime < file_b->mtime)
+    return -1;
+
+  return file_a->mtime > file_b->mtime;
+}
+
+/* the only directory scan, what previous sessions saved is ordered by mtime
+ * and everything after that is tracked in memory */
+static void
+ensure_entries(const char *dir)
+{
+  GArray *files;
+  GDir *gdir;
+  const char *name;
+  guint i;
+
+  if (entries)
+    return;
+
+  entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+  gdir = g_dir_open(dir, 0, NULL);
+
+  if (!gdir)
+    return;
+
+  files = g_array_new(FALSE, FALSE, sizeof(OssoABookHomeThumbnailFile));
+
+  while ((name = g_dir_read_name(gdir)))
+  {
+    OssoABookHomeThumbnailFile file;
+    gchar *path;
+    GStatBuf st;
+
+    if (!g_str_has_suffix(name, THUMBNAIL_SUFFIX))
+      continue;
+
+    path = g_build_filename(dir, name, NULL);
+
+    if (!g_stat(path, &st))
+    {
+      file.name = g_strdup(name);
+      file.mtime = st.st_mtime;
+      file.size = st.st_size;
+      g_array_append_val(files, file);
+    }
+
+    g_free(path);
+  }
+
+  g_dir_close(gdir);
+  g_array_sort(files, compare_files);
+
+  for (i = 0; i < files->len; i++)
+  {
+    OssoABookHomeThumbnailFile *file =
+      &g_array_index(files, OssoABookHomeThumbnailFile, i);
+    OssoABookHomeThumbnailEntry *entry = g_new(OssoABookHomeThumbnailEntry, 1);
+
+    entry->size = file->size;
+    entry->used = ++use_count;
+    total_size += entry->size;
+    g_hash_table_insert(entries, file->name, entry);
+  }
+
+  g_array_free(files, TRUE);
+}
+
+static void
+set_entry(const char *name, goffset size)
+{
+  OssoABookHomeThumbnailEntry *entry = g_hash_table_lookup(entries, name);
+
+  if (entry)
+    total_size -= entry->size;
+  else
+  {
+    entry = g_new(OssoABookHomeThumbnailEntry, 1);
+    g_hash_table_insert(entries, g_strdup(name), entry);
+  }
+
+  entry->size = size;
+  entry->used = ++use_count;
+  total_size += size;
+}
+
+static void
+remove_entry(const char *name)
+{
+  OssoABookHomeThumbnailEntry *entry = g_hash_table_lookup(entries, name);
+
+  if (entry)
+  {
+    total_size -= entry->size;
+    g_hash_table_remove(entries, name);
+  }
+}
+
+static void
+mapped_file_unref(void *data)
+{
+  g_mapped_file_unref(data);
+}
+
+static gboolean
+header_is_valid(const OssoABookHomeThumbnailHeader *header, gsize length)
+{
+  if ((length < sizeof(*header)) ||
+      (header->magic != THUMBNAIL_MAGIC) ||
+      (header->version != THUMBNAIL_VERSION) ||
+      !header->width || !header->height)
+  {
+    return FALSE;
+  }
+
+  if (header->stride !=
+      (guint32)cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32,
+                                             header->width))
+  {
+    return FALSE;
+  }
+
+  return length - sizeof(*header) >= (gsize)header->stride * header->height;
+}
+
+cairo_surface_t *
+osso_abook_home_thumbnail_store_lookup(const char *key, int size)
+{
+  const OssoABookHomeThumbnailHeader *header;
+  cairo_surface_t *surface;
+  GMappedFile *file;
+  gchar *name;
+  gchar *path;
+  gchar *dir;
+
+  g_return_val_if_fail(key != NULL, NULL);
+
+  dir = get_store_dir();
+  ensure_entries(dir);
+  name = get_thumbnail_name(key, size);
+  path = g_build_filename(dir, name, NULL);
+  g_free(dir);
+  file = g_mapped_file_new(path, FALSE, NULL);
+
+  if (!file)
+  {
+    remove_entry(name);
+    g_free(path);
+    g_free(name);
+
+    return NULL;
+  }
+
+  header = (const OssoABookHomeThumbnailHeader *)
+    g_mapped_file_get_contents(file);
+
+  if (!header_is_valid(header, g_mapped_file_get_length(file)))
+  {
+    g_warning("%s: dropping invalid thumbnail %s", __FUNCTION__, path);
+    g_mapped_file_unref(file);
+    g_unlink(path);
+    remove_entry(name);
+    g_free(path);
+    g_free(name);
+
+    return NULL;
+  }
+
+  /* the mapping is read-only, the surface is only ever used as a source */
+  surface = cairo_image_surface_create_for_data(
+      (unsigned char *)(header + 1), CAIRO_FORMAT_ARGB32,
+      header->width, header->height, header->stride);
+
+  if (cairo_surface_set_user_data(surface, &mapped_file_key, file,
+                                  mapped_file_unref) != CAIRO_STATUS_SUCCESS)
+  {
+    cairo_surface_destroy(surface);
+    g_mapped_file_unref(file);
+    g_free(path);
+    g_free(name);
+
+    return NULL;
+  }
+
+  /* no disk write on a hit, the use is only recorded in memory */
+  set_entry(name, g_mapped_file_get_length(file));
+  g_free(path);
+  g_free(name);
+
+  return surface;
+}
+
+gboolean
+osso_abook_home_thumbnail_store_is_mapped(cairo_surface_t *surface)
+{
+  return cairo_surface_get_user_data(surface, &mapped_file_key) != NULL;
+}
+
+static gint
+compare_entries(gconstpointer a, gconstpointer b)
+{
+  const OssoABookHomeThumbnailEntry *entry_a =
+    g_hash_table_lookup(entries, *(const char **)a);
+  const OssoABookHomeThumbnailEntry *entry_b =
+    g_hash_table_lookup(entries, *(const char **)b);
+
+  if (entry_a->used < entry_b->used)
+    return -1;
+
+  return entry_a->used > entry_b->used;
+}
+
+/* only called once the running total crosses the cap, keep is the thumbnail
+ * that was just saved */
+static void
+evict(const char *dir, const char *keep)
+{
+  GPtrArray *names = g_ptr_array_sized_new(g_hash_table_size(entries));
+  GHashTableIter iter;
+  gpointer name;
+  guint i;
+
+  g_hash_table_iter_init(&iter, entries);
+
+  while (g_hash_table_iter_next(&iter, &name, NULL))
+  {
+    if (strcmp(name, keep))
+      g_ptr_array_add(names, g_strdup(name));
+  }
+
+  g_ptr_array_sort(names, compare_entries);
+
+  for (i = 0; i < names->len; i++)
+  {
+    gchar *path;
+
+    if (total_size <= OSSO_ABOOK_HOME_THUMBNAIL_STORE_MAX_SIZE)
+      break;
+
+    path = g_build_filename(dir, names->pdata[i], NULL);
+
+    /* mappings other processes hold on unlinked files stay valid */
+    if (!g_unlink(path) || (errno == ENOENT))
+      remove_entry(names->pdata[i]);
+
+    g_free(path);
+  }
+
+  g_ptr_array_foreach(names, (GFunc)g_free, NULL);
+  g_ptr_array_free(names, TRUE);
+}
+
+void
+osso_abook_home_thumbnail_store_save(const char *key, int size,
+                                     cairo_surface_t *surface)
+{
+  OssoABookHomeThumbnailHeader header;
+  GError *error = NULL;
+  gchar *contents;
+  gsize length;
+  gchar *name;
+  gchar *path;
+  gchar *dir;
+
+  g_return_if_fail(key != NULL);
+  g_return_if_fail(
+    cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE &&
+    cairo_image_surface_get_format(surface) == CAIRO_FORMAT_ARGB32);
+
+  memset(&header, 0, sizeof(header));
+  header.magic = THUMBNAIL_MAGIC;
+  header.version = THUMBNAIL_VERSION;
+  header.width = cairo_image_surface_get_width(surface);
+  header.height = cairo_image_surface_get_height(surface);
+  header.stride = cairo_image_surface_get_stride(surface);
+
+  cairo_surface_flush(surface);
+  length = sizeof(header) + header.stride * header.height;
+  contents = g_malloc(length);
+  memcpy(contents, &header, sizeof(header));
+  memcpy(contents + sizeof(header), cairo_image_surface_get_data(surface),
+         header.stride * header.height);
+
+  dir = get_store_dir();
+  ensure_entries(dir);
+  name = get_thumbnail_name(key, size);
+  path = g_build_filename(dir, name, NULL);
+
+  /* g_file_set_contents() writes a temporary and renames it over, readers
+   * never see a partial thumbnail */
+  if (g_mkdir_with_parents(dir, 0700))
+    g_warning("%s: unable to create %s", __FUNCTION__, dir);
+  else if (!g_file_set_contents(path, contents, length, &error))
+  {
+    g_warning("%s: %s", __FUNCTION__, error->message);
+    g_clear_error(&error);
+  }
+  else
+  {
+    set_entry(name, length);
+
+    if (total_size > OSSO_ABOOK_HOME_THUMBNAIL_STORE_MAX_SIZE)
+      evict(dir, name);
+  }
+
+  g_free(path);
+  g_free(name);
+  g_free(dir);
+  g_free(contents);
+}
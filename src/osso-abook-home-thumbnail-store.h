@@ -0,0 +1,59 @@
+/*
+ * osso-abook-home-thumbnail-store.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_THUMBNAIL_STORE_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_THUMBNAIL_STORE_H_INCLUDED__
+
+#include <cairo.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* total size of the store on disk above which the least recently used
+ * thumbnails are removed, in bytes */
+#ifndef OSSO_ABOOK_HOME_THUMBNAIL_STORE_MAX_SIZE
+#define OSSO_ABOOK_HOME_THUMBNAIL_STORE_MAX_SIZE (2 * 1024 * 1024)
+#endif
+
+/* Scaled avatars, stored as premultiplied ARGB32 pixels under
+ * $XDG_CACHE_HOME/osso-abook-home-applet, keyed by a hash of where the
+ * avatar comes from and its version, and by the size they were scaled to.
+ * Lookups mmap the file and wrap the mapping in an image surface, there is
+ * no decoding involved. The directory is scanned once, sizes and use order
+ * are then kept in memory. */
+
+/* source is a short string that changes whenever the avatar does, the key
+ * is owned by the store and valid until the next call */
+const char *
+osso_abook_home_thumbnail_store_get_key(const char *source);
+
+cairo_surface_t *
+osso_abook_home_thumbnail_store_lookup(const char *key, int size);
+
+/* TRUE if surface maps a stored thumbnail and must not be drawn to */
+gboolean
+osso_abook_home_thumbnail_store_is_mapped(cairo_surface_t *surface);
+
+void
+osso_abook_home_thumbnail_store_save(const char *key, int size,
+                                     cairo_surface_t *surface);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_THUMBNAIL_STORE_H_INCLUDED__ */
@@ -0,0 +1,374 @@
+/*
+ * osso-abook-home-trace.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "osso-abook-home-applet.h"
+#include "osso-abook-home-trace.h"
+
+#define TRACE_MAGIC "OAHTRC02"
+#define TRACE_MAGIC_LENGTH 8
+#define SALT_LENGTH 16
+
+#define WATCHED_KEY "osso-abook-home-trace-watched"
+#define AVATAR_TOKEN_KEY "osso-abook-home-trace-avatar-token"
+#define AVATAR_SERIAL_KEY "osso-abook-home-trace-avatar-serial"
+
+/* the magic is followed by events, each one is
+ *   guint8 type, guint32 delay, guint16 n_contacts, contacts[n_contacts]
+ * with every contact being
+ *   guint64 id, guint8 presence_type, guint8 name_length,
+ *   guint16 avatar_serial
+ * in host byte order, traces are replayed on the kind of device that
+ * recorded them */
+
+static FILE *trace_file = NULL;
+static gboolean trace_checked = FALSE;
+static guchar salt[SALT_LENGTH];
+static gint64 last_time = 0;
+
+static gboolean
+trace_open()
+{
+  const char *path;
+  int i;
+
+  if (trace_checked)
+    return trace_file != NULL;
+
+  trace_checked = TRUE;
+  path = g_getenv(OSSO_ABOOK_HOME_TRACE_ENV);
+
+  if (!path || !*path)
+    return FALSE;
+
+  trace_file = fopen(path, "wb");
+
+  if (!trace_file)
+  {
+    g_warning("%s: unable to open %s", __FUNCTION__, path);
+    return FALSE;
+  }
+
+  /* a new salt per trace, so hashes can't be matched across traces */
+  for (i = 0; i < SALT_LENGTH; i++)
+    salt[i] = g_random_int_range(0, 256);
+
+  osso_abook_home_trace_write_header(trace_file);
+  last_time = g_get_monotonic_time();
+
+  return TRUE;
+}
+
+static guint64
+hash_uid(const char *uid)
+{
+  GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA1);
+  guint8 digest[20];
+  gsize length = sizeof(digest);
+  guint64 id;
+
+  g_checksum_update(checksum, salt, sizeof(salt));
+  g_checksum_update(checksum, (const guchar *)(uid ? uid : ""), -1);
+  g_checksum_get_digest(checksum, digest, &length);
+  g_checksum_free(checksum);
+  memcpy(&id, digest, sizeof(id));
+
+  return id;
+}
+
+static void
+set_id(OssoABookHomeTraceContact *trace_contact, const char *uid)
+{
+  memset(trace_contact, 0, sizeof(*trace_contact));
+  trace_contact->id = hash_uid(uid);
+}
+
+/* the name only by its length, which is what the layout costs depend on */
+static void
+set_contact(OssoABookHomeTraceContact *trace_contact,
+            OssoABookContact *contact)
+{
+  const char *name = osso_abook_home_applet_get_contact_name(contact);
+
+  set_id(trace_contact, e_contact_get_const(E_CONTACT(contact),
+                                            E_CONTACT_UID));
+  trace_contact->presence_type =
+    osso_abook_presence_get_presence_type(OSSO_ABOOK_PRESENCE(contact));
+  trace_contact->name_length = name ? MIN(g_utf8_strlen(name, -1), 255) : 0;
+  trace_contact->avatar_serial = GPOINTER_TO_UINT(
+      g_object_get_data(G_OBJECT(contact), AVATAR_SERIAL_KEY));
+}
+
+static void
+write_event(OssoABookHomeTraceType type, OssoABookHomeTraceContact *contacts,
+            guint n_contacts)
+{
+  OssoABookHomeTraceEvent event;
+  gint64 now = g_get_monotonic_time();
+
+  event.type = type;
+  event.delay = MIN(now - last_time, G_MAXUINT32);
+  event.n_contacts = n_contacts;
+  event.contacts = contacts;
+  last_time = now;
+  osso_abook_home_trace_write(trace_file, &event);
+
+  /* the trace of an applet that crashed is the one we want the most */
+  fflush(trace_file);
+}
+
+static void
+write_contact_event(OssoABookHomeTraceType type, OssoABookContact *contact)
+{
+  OssoABookHomeTraceContact trace_contact;
+
+  set_contact(&trace_contact, contact);
+  write_event(type, &trace_contact, 1);
+}
+
+void
+osso_abook_home_trace_applet(const char *uid)
+{
+  OssoABookHomeTraceContact trace_contact;
+
+  if (!trace_open())
+    return;
+
+  set_id(&trace_contact, uid);
+  write_event(OSSO_ABOOK_HOME_TRACE_APPLET, &trace_contact, 1);
+}
+
+static void
+contacts_added_cb(OssoABookRoster *roster, OssoABookContact **contacts,
+                  gpointer user_data)
+{
+  GArray *trace_contacts =
+    g_array_new(FALSE, FALSE, sizeof(OssoABookHomeTraceContact));
+
+  for (; *contacts && (trace_contacts->len < G_MAXUINT16); contacts++)
+  {
+    OssoABookHomeTraceContact trace_contact;
+
+    set_contact(&trace_contact, *contacts);
+    g_array_append_val(trace_contacts, trace_contact);
+  }
+
+  write_event(OSSO_ABOOK_HOME_TRACE_CONTACTS_ADDED,
+              (OssoABookHomeTraceContact *)trace_contacts->data,
+              trace_contacts->len);
+  g_array_free(trace_contacts, TRUE);
+}
+
+static void
+contacts_removed_cb(OssoABookRoster *roster, const char **uids,
+                    gpointer user_data)
+{
+  GArray *trace_contacts =
+    g_array_new(FALSE, FALSE, sizeof(OssoABookHomeTraceContact));
+
+  for (; *uids && (trace_contacts->len < G_MAXUINT16); uids++)
+  {
+    OssoABookHomeTraceContact trace_contact;
+
+    set_id(&trace_contact, *uids);
+    g_array_append_val(trace_contacts, trace_contact);
+  }
+
+  write_event(OSSO_ABOOK_HOME_TRACE_CONTACTS_REMOVED,
+              (OssoABookHomeTraceContact *)trace_contacts->data,
+              trace_contacts->len);
+  g_array_free(trace_contacts, TRUE);
+}
+
+void
+osso_abook_home_trace_watch_roster(OssoABookRoster *roster)
+{
+  if (!trace_open())
+    return;
+
+  g_signal_connect(roster, "contacts-added",
+                   G_CALLBACK(contacts_added_cb), NULL);
+  g_signal_connect(roster, "contacts-removed",
+                   G_CALLBACK(contacts_removed_cb), NULL);
+}
+
+/* the serial goes up whenever the applets would load a new avatar, so the
+ * replay does the same amount of avatar work */
+static void
+update_avatar_serial(OssoABookContact *contact, gboolean force)
+{
+  GObject *object = G_OBJECT(contact);
+  gconstpointer token =
+    osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(contact));
+  guint serial;
+
+  if (!force && (token == g_object_get_data(object, AVATAR_TOKEN_KEY)))
+    return;
+
+  serial = GPOINTER_TO_UINT(g_object_get_data(object, AVATAR_SERIAL_KEY));
+  g_object_set_data(object, AVATAR_TOKEN_KEY, (gpointer)token);
+  g_object_set_data(object, AVATAR_SERIAL_KEY,
+                    GUINT_TO_POINTER((serial + 1) & G_MAXUINT16));
+}
+
+static void
+contact_notify_presence_type_cb(OssoABookContact *contact, GParamSpec *pspec,
+                                gpointer user_data)
+{
+  write_contact_event(OSSO_ABOOK_HOME_TRACE_PRESENCE_TYPE, contact);
+}
+
+static void
+contact_notify_avatar_image_cb(OssoABookContact *contact, GParamSpec *pspec,
+                               gpointer user_data)
+{
+  update_avatar_serial(contact, TRUE);
+  write_contact_event(OSSO_ABOOK_HOME_TRACE_AVATAR_IMAGE, contact);
+}
+
+static void
+contact_reset_cb(OssoABookContact *contact, gpointer user_data)
+{
+  update_avatar_serial(contact, FALSE);
+  write_contact_event(OSSO_ABOOK_HOME_TRACE_RESET, contact);
+}
+
+/* several tiles can show the same contact, record its signals once */
+void
+osso_abook_home_trace_watch_contact(OssoABookContact *contact)
+{
+  if (!trace_open() || g_object_get_data(G_OBJECT(contact), WATCHED_KEY))
+    return;
+
+  g_object_set_data(G_OBJECT(contact), WATCHED_KEY, GINT_TO_POINTER(TRUE));
+  g_object_set_data(
+    G_OBJECT(contact), AVATAR_TOKEN_KEY,
+    (gpointer)osso_abook_avatar_get_image_token(OSSO_ABOOK_AVATAR(contact)));
+  g_signal_connect(contact, "notify::presence-type",
+                   G_CALLBACK(contact_notify_presence_type_cb), NULL);
+  g_signal_connect(contact, "notify::avatar-image",
+                   G_CALLBACK(contact_notify_avatar_image_cb), NULL);
+  g_signal_connect(contact, "reset", G_CALLBACK(contact_reset_cb), NULL);
+}
+
+void
+osso_abook_home_trace_write_header(FILE *file)
+{
+  fwrite(TRACE_MAGIC, TRACE_MAGIC_LENGTH, 1, file);
+}
+
+void
+osso_abook_home_trace_write(FILE *file, const OssoABookHomeTraceEvent *event)
+{
+  guint8 type = event->type;
+  guint16 n_contacts = MIN(event->n_contacts, G_MAXUINT16);
+  guint i;
+
+  fwrite(&type, sizeof(type), 1, file);
+  fwrite(&event->delay, sizeof(event->delay), 1, file);
+  fwrite(&n_contacts, sizeof(n_contacts), 1, file);
+
+  /* field by field, the struct has padding */
+  for (i = 0; i < n_contacts; i++)
+  {
+    const OssoABookHomeTraceContact *contact = &event->contacts[i];
+
+    fwrite(&contact->id, sizeof(contact->id), 1, file);
+    fwrite(&contact->presence_type, sizeof(contact->presence_type), 1, file);
+    fwrite(&contact->name_length, sizeof(contact->name_length), 1, file);
+    fwrite(&contact->avatar_serial, sizeof(contact->avatar_serial), 1, file);
+  }
+}
+
+gboolean
+osso_abook_home_trace_read_header(FILE *file)
+{
+  char magic[TRACE_MAGIC_LENGTH];
+
+  if (fread(magic, sizeof(magic), 1, file) != 1)
+    return FALSE;
+
+  return !memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_LENGTH);
+}
+
+static gboolean
+read_contact(FILE *file, OssoABookHomeTraceContact *contact)
+{
+  return (fread(&contact->id, sizeof(contact->id), 1, file) == 1) &&
+         (fread(&contact->presence_type, sizeof(contact->presence_type), 1,
+                file) == 1) &&
+         (fread(&contact->name_length, sizeof(contact->name_length), 1,
+                file) == 1) &&
+         (fread(&contact->avatar_serial, sizeof(contact->avatar_serial), 1,
+                file) == 1);
+}
+
+gboolean
+osso_abook_home_trace_read(FILE *file, OssoABookHomeTraceEvent *event)
+{
+  guint8 type;
+  guint16 n_contacts;
+  guint i;
+
+  memset(event, 0, sizeof(*event));
+
+  if ((fread(&type, sizeof(type), 1, file) != 1) ||
+      (fread(&event->delay, sizeof(event->delay), 1, file) != 1) ||
+      (fread(&n_contacts, sizeof(n_contacts), 1, file) != 1) ||
+      (type >= OSSO_ABOOK_HOME_TRACE_LAST))
+  {
+    return FALSE;
+  }
+
+  event->type = type;
+  event->n_contacts = n_contacts;
+
+  if (n_contacts)
+  {
+    event->contacts = g_new0(OssoABookHomeTraceContact, n_contacts);
+
+    for (i = 0; i < n_contacts; i++)
+    {
+      if (!read_contact(file, &event->contacts[i]))
+      {
+        osso_abook_home_trace_event_clear(event);
+        return FALSE;
+      }
+    }
+  }
+
+  return TRUE;
+}
+
+void
+osso_abook_home_trace_event_clear(OssoABookHomeTraceEvent *event)
+{
+  g_free(event->contacts);
+  event->contacts = NULL;
+  event->n_contacts = 0;
+}
+
+gchar *
+osso_abook_home_trace_format_id(guint64 id)
+{
+  return g_strdup_printf("%016" G_GINT64_MODIFIER "x", id);
+}
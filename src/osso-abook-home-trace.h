@@ -0,0 +1,98 @@
+/*
+ * osso-abook-home-trace.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_TRACE_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_TRACE_H_INCLUDED__
+
+#include <libosso-abook/osso-abook-contact.h>
+#include <libosso-abook/osso-abook-roster.h>
+
+#include <stdio.h>
+
+G_BEGIN_DECLS
+
+/* when set, the roster and contact signals the applets see are written to
+ * the file it names, replacing whatever it held */
+#define OSSO_ABOOK_HOME_TRACE_ENV "OSSO_ABOOK_HOME_TRACE"
+
+typedef enum
+{
+  OSSO_ABOOK_HOME_TRACE_APPLET,
+  OSSO_ABOOK_HOME_TRACE_CONTACTS_ADDED,
+  OSSO_ABOOK_HOME_TRACE_CONTACTS_REMOVED,
+  OSSO_ABOOK_HOME_TRACE_PRESENCE_TYPE,
+  OSSO_ABOOK_HOME_TRACE_AVATAR_IMAGE,
+  OSSO_ABOOK_HOME_TRACE_RESET,
+  OSSO_ABOOK_HOME_TRACE_LAST
+} OssoABookHomeTraceType;
+
+/* contact UIDs never hit the disk, only a salted hash of them, which stays
+ * the same for the whole trace. Of the contact itself only what decides the
+ * work the applets do is kept, and only for contacts-added and the contact
+ * signals, other events leave it 0. */
+struct _OssoABookHomeTraceContact
+{
+  guint64 id;
+  guint8 presence_type;         /* TpConnectionPresenceType */
+  guint8 name_length;           /* in characters, at most 255 */
+  guint16 avatar_serial;        /* bumped on every avatar change */
+};
+
+typedef struct _OssoABookHomeTraceContact OssoABookHomeTraceContact;
+
+struct _OssoABookHomeTraceEvent
+{
+  OssoABookHomeTraceType type;
+  guint32 delay;                /* microseconds since the previous event */
+  guint n_contacts;
+  OssoABookHomeTraceContact *contacts;
+};
+
+typedef struct _OssoABookHomeTraceEvent OssoABookHomeTraceEvent;
+
+void
+osso_abook_home_trace_applet(const char *uid);
+
+void
+osso_abook_home_trace_watch_roster(OssoABookRoster *roster);
+
+void
+osso_abook_home_trace_watch_contact(OssoABookContact *contact);
+
+void
+osso_abook_home_trace_write_header(FILE *file);
+
+void
+osso_abook_home_trace_write(FILE *file, const OssoABookHomeTraceEvent *event);
+
+gboolean
+osso_abook_home_trace_read_header(FILE *file);
+
+gboolean
+osso_abook_home_trace_read(FILE *file, OssoABookHomeTraceEvent *event);
+
+void
+osso_abook_home_trace_event_clear(OssoABookHomeTraceEvent *event);
+
+gchar *
+osso_abook_home_trace_format_id(guint64 id);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_TRACE_H_INCLUDED__ */
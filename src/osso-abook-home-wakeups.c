@@ -0,0 +1,187 @@
+/*
+ * osso-abook-home-wakeups.c
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#include "osso-abook-home-wakeups.h"
+
+struct _OssoABookHomeWakeupSource
+{
+  OssoABookHomeWakeupOrigin origin;
+  GSourceFunc function;
+  gpointer data;
+};
+
+typedef struct _OssoABookHomeWakeupSource OssoABookHomeWakeupSource;
+
+static const char *origin_names[OSSO_ABOOK_HOME_WAKEUP_LAST] =
+{
+  "recovery",
+  "update-applets",
+  "expose",
+  "startup"
+};
+
+static guint wakeups[OSSO_ABOOK_HOME_WAKEUP_LAST];
+
+/* dispatches of sources that asked to be called again, on an idle device
+ * with nothing changing this has to stay 0 */
+static guint periodic[OSSO_ABOOK_HOME_WAKEUP_LAST];
+
+/* NULL until the main loop is watched */
+static GPollFunc main_loop_poll = NULL;
+static guint main_loop_wakeups = 0;
+
+static gboolean
+wakeup_source_cb(gpointer user_data)
+{
+  OssoABookHomeWakeupSource *source = user_data;
+  gboolean rv;
+
+  wakeups[source->origin]++;
+  rv = source->function(source->data);
+
+  if (rv)
+    periodic[source->origin]++;
+
+  return rv;
+}
+
+static void
+wakeup_source_free(gpointer user_data)
+{
+  g_slice_free(OssoABookHomeWakeupSource, user_data);
+}
+
+static OssoABookHomeWakeupSource *
+wakeup_source_new(OssoABookHomeWakeupOrigin origin, GSourceFunc function,
+                  gpointer data)
+{
+  OssoABookHomeWakeupSource *source = g_slice_new(OssoABookHomeWakeupSource);
+
+  source->origin = origin;
+  source->function = function;
+  source->data = data;
+
+  return source;
+}
+
+guint
+osso_abook_home_wakeups_timeout_add_seconds(OssoABookHomeWakeupOrigin origin,
+                                            guint interval,
+                                            GSourceFunc function,
+                                            gpointer data)
+{
+  g_return_val_if_fail(origin < OSSO_ABOOK_HOME_WAKEUP_LAST, 0);
+
+  /* second granularity lets glib fire all of them, ours and everybody
+   * else's in the session, on the same wakeup */
+  return g_timeout_add_seconds_full(G_PRIORITY_DEFAULT, interval,
+                                    wakeup_source_cb,
+                                    wakeup_source_new(origin, function, data),
+                                    wakeup_source_free);
+}
+
+guint
+osso_abook_home_wakeups_idle_add(OssoABookHomeWakeupOrigin origin,
+                                 GSourceFunc function,
+                                 gpointer data)
+{
+  return osso_abook_home_wakeups_idle_add_full(origin, G_PRIORITY_DEFAULT_IDLE,
+                                               function, data);
+}
+
+guint
+osso_abook_home_wakeups_idle_add_full(OssoABookHomeWakeupOrigin origin,
+                                      gint priority,
+                                      GSourceFunc function,
+                                      gpointer data)
+{
+  g_return_val_if_fail(origin < OSSO_ABOOK_HOME_WAKEUP_LAST, 0);
+
+  return g_idle_add_full(priority, wakeup_source_cb,
+                         wakeup_source_new(origin, function, data),
+                         wakeup_source_free);
+}
+
+void
+osso_abook_home_wakeups_count(OssoABookHomeWakeupOrigin origin)
+{
+  g_return_if_fail(origin < OSSO_ABOOK_HOME_WAKEUP_LAST);
+
+  wakeups[origin]++;
+}
+
+guint
+osso_abook_home_wakeups_get_periodic()
+{
+  guint count = 0;
+  int i;
+
+  for (i = 0; i < OSSO_ABOOK_HOME_WAKEUP_LAST; i++)
+    count += periodic[i];
+
+  return count;
+}
+
+static gint
+wakeup_poll(GPollFD *ufds, guint nfds, gint timeout)
+{
+  gint rv = main_loop_poll(ufds, nfds, timeout);
+
+  /* a 0 timeout only checks the fds, it never sleeps */
+  if (timeout)
+    main_loop_wakeups++;
+
+  return rv;
+}
+
+void
+osso_abook_home_wakeups_watch_main_loop()
+{
+  if (main_loop_poll)
+    return;
+
+  main_loop_poll = g_main_context_get_poll_func(NULL);
+  g_main_context_set_poll_func(NULL, wakeup_poll);
+}
+
+guint
+osso_abook_home_wakeups_get_main_loop()
+{
+  return main_loop_wakeups;
+}
+
+gchar *
+osso_abook_home_wakeups_report()
+{
+  GString *report = g_string_new("Wakeups:\n");
+  int i;
+
+  for (i = 0; i < OSSO_ABOOK_HOME_WAKEUP_LAST; i++)
+  {
+    g_string_append_printf(report, "  %s: %u (%u periodic)\n",
+                           origin_names[i], wakeups[i], periodic[i]);
+  }
+
+  if (main_loop_poll)
+    g_string_append_printf(report, "  main loop: %u\n", main_loop_wakeups);
+
+  return g_string_free(report, FALSE);
+}
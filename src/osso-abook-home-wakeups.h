@@ -0,0 +1,72 @@
+/*
+ * osso-abook-home-wakeups.h
+ *
+ * Copyright (C) 2022 Ivaylo Dimitrov <ivo.g.dimitrov.75@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef __OSSO_ABOOK_HOME_WAKEUPS_H_INCLUDED__
+#define __OSSO_ABOOK_HOME_WAKEUPS_H_INCLUDED__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  OSSO_ABOOK_HOME_WAKEUP_RECOVERY,
+  OSSO_ABOOK_HOME_WAKEUP_UPDATE_APPLETS,
+  OSSO_ABOOK_HOME_WAKEUP_EXPOSE,
+  OSSO_ABOOK_HOME_WAKEUP_STARTUP,
+  OSSO_ABOOK_HOME_WAKEUP_LAST
+} OssoABookHomeWakeupOrigin;
+
+guint
+osso_abook_home_wakeups_timeout_add_seconds(OssoABookHomeWakeupOrigin origin,
+                                            guint interval,
+                                            GSourceFunc function,
+                                            gpointer data);
+
+guint
+osso_abook_home_wakeups_idle_add(OssoABookHomeWakeupOrigin origin,
+                                 GSourceFunc function,
+                                 gpointer data);
+
+guint
+osso_abook_home_wakeups_idle_add_full(OssoABookHomeWakeupOrigin origin,
+                                      gint priority,
+                                      GSourceFunc function,
+                                      gpointer data);
+
+void
+osso_abook_home_wakeups_count(OssoABookHomeWakeupOrigin origin);
+
+guint
+osso_abook_home_wakeups_get_periodic(void);
+
+/* counts every time the default main context sleeps in poll() and gets
+ * woken up, whatever the source, ours or not */
+void
+osso_abook_home_wakeups_watch_main_loop(void);
+
+guint
+osso_abook_home_wakeups_get_main_loop(void);
+
+gchar *
+osso_abook_home_wakeups_report(void);
+
+G_END_DECLS
+
+#endif /* __OSSO_ABOOK_HOME_WAKEUPS_H_INCLUDED__ */